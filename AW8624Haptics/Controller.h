@@ -13,10 +13,68 @@ AW8624Stop(
 );
 NTSTATUS
 AW8624VibrateUntilStopped(
+	IN PDEVICE_CONTEXT pDevice,
+	IN ULONG Intensity
+);
+
+VOID
+AW8624LoadProfile(
 	IN PDEVICE_CONTEXT pDevice
 );
 
 NTSTATUS
 AW8624Initialize(
 	IN PDEVICE_CONTEXT pDevice
-);
\ No newline at end of file
+);
+
+NTSTATUS
+AW8624Suspend(
+	IN PDEVICE_CONTEXT pDevice
+);
+
+NTSTATUS
+AW8624Resume(
+	IN PDEVICE_CONTEXT pDevice
+);
+
+BOOLEAN
+AW8624InterruptService(
+	IN PDEVICE_CONTEXT pDevice
+);
+
+NTSTATUS
+AW8624Recover(
+	IN PDEVICE_CONTEXT pDevice
+);
+
+NTSTATUS
+AW8624Vibrate(
+	IN PDEVICE_CONTEXT pDevice,
+	IN ULONG Intensity
+);
+
+NTSTATUS
+AW8624PlayEffectChain(
+	IN PDEVICE_CONTEXT pDevice,
+	IN PAW8624_EFFECT_CHAIN Chain,
+	IN ULONG Intensity
+);
+
+NTSTATUS
+AW8624Blink(
+	IN PDEVICE_CONTEXT pDevice,
+	IN ULONG HwNId,
+	IN ULONG PeriodMs,
+	IN ULONG DutyCycle,
+	IN ULONG CycleCount,
+	IN ULONG Intensity
+);
+
+VOID
+AW8624BlinkCancel(
+	IN PDEVICE_CONTEXT pDevice
+);
+
+EVT_WDF_WORKITEM AW8624SetupWorkItem;
+EVT_WDF_TIMER AW8624BlinkTimer;
+EVT_WDF_WORKITEM AW8624BlinkWorkItem;
\ No newline at end of file
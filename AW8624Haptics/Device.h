@@ -28,11 +28,165 @@ EXTERN_C_START
 
 #define HAPTICS_POOL_TAG 'HnwH'
 
-typedef struct _AW8624_HAPTICS_CURRENT_STATE
+//
+// Shadow copy of the AW8624 register map, used to serve
+// read-modify-write cycles on non-volatile registers from memory
+//
+typedef struct _AW8624_REGISTER_CACHE
+{
+	UCHAR Value[AW8624_REGISTER_COUNT];
+	BOOLEAN Valid[AW8624_REGISTER_COUNT];
+
+	ULONG Hits;
+	ULONG Misses;
+} AW8624_REGISTER_CACHE, * PAW8624_REGISTER_CACHE;
+
+//
+// Set-state requests accepted from HwnClx, executed by a single work
+// item and completed through a callback. Each HwN id has one pending
+// slot, so a request that arrives before the previous one for the same
+// id has run replaces it, and only the latest target state is applied.
+//
+#define AW8624_MAX_HWN_DEVICES 16
+
+struct _DEVICE_CONTEXT;
+
+typedef VOID AW8624_REQUEST_COMPLETION(
+	struct _DEVICE_CONTEXT* devContext,
+	PHWN_SETTINGS hwnSettings,
+	NTSTATUS Status
+);
+
+typedef AW8624_REQUEST_COMPLETION* PFN_AW8624_REQUEST_COMPLETION;
+
+typedef struct _AW8624_REQUEST
+{
+	BOOLEAN Pending;
+	HWN_SETTINGS Settings;
+	PFN_AW8624_REQUEST_COMPLETION Completion;
+} AW8624_REQUEST, * PAW8624_REQUEST;
+
+typedef struct _AW8624_REQUEST_QUEUE
+{
+	AW8624_REQUEST Requests[AW8624_MAX_HWN_DEVICES];
+	ULONG PendingCount;
+
+	WDFWAITLOCK Lock;
+	WDFWORKITEM WorkItem;
+
+	// Set outside D0, requests are still accepted but only run on D0 entry
+	BOOLEAN Stopped;
+
+	ULONG Accepted;
+	ULONG Collapsed;
+	ULONG Executed;
+	ULONG Batches;
+} AW8624_REQUEST_QUEUE, * PAW8624_REQUEST_QUEUE;
+
+//
+// Chain of RAM effects played by the chip's sequencer. Each step is
+// a waveform index, or with Wait set a pause, repeated Loops extra
+// times (15 repeats forever). The whole chain then repeats MainLoops
+// extra times.
+//
+#define AW8624_EFFECT_CHAIN_STEPS 8
+
+typedef struct _AW8624_EFFECT_STEP
+{
+	UINT8 Effect;
+	BOOLEAN Wait;
+	UINT8 Loops;
+} AW8624_EFFECT_STEP, * PAW8624_EFFECT_STEP;
+
+typedef struct _AW8624_EFFECT_CHAIN
+{
+	ULONG StepCount;
+	AW8624_EFFECT_STEP Steps[AW8624_EFFECT_CHAIN_STEPS];
+	UINT8 MainLoops;
+} AW8624_EFFECT_CHAIN, * PAW8624_EFFECT_CHAIN;
+
+//
+// HWN_BLINK pattern, generated by a timer that only toggles GO per edge
+//
+typedef struct _AW8624_BLINK
+{
+	WDFTIMER Timer;
+	WDFWORKITEM WorkItem;
+
+	volatile LONG Active;
+	BOOLEAN On;
+	ULONG HwNId;
+	ULONG OnTimeMs;
+	ULONG OffTimeMs;
+	ULONG CyclesLeft;
+
+	//
+	// Bumped on every cancel, and so before every new pattern. The timer stamps
+	// the edge it queues with it, so a work item that was already queued
+	// when its pattern got replaced drops the edge instead of acting on
+	// the new pattern.
+	//
+	volatile LONG Generation;
+	volatile LONG QueuedGeneration;
+
+	//
+	// Set by an off edge until its DONE arrives. The off edge already
+	// ended playback, and a late DONE must not end the playback the
+	// next on edge started.
+	//
+	volatile LONG OffEdgeDonePending;
+
+	ULONG Edges;
+} AW8624_BLINK, * PAW8624_BLINK;
+
+//
+// HWN_INTENSITY is a percentage, 0 through 100
+//
+#define AW8624_INTENSITY_LEVELS 101
+
+typedef struct _AW8624_DRIVE_LEVEL
+{
+	UINT8 DrvLvl;
+	UINT8 DrvLvlOv;
+	UINT8 RamGain;
+} AW8624_DRIVE_LEVEL, * PAW8624_DRIVE_LEVEL;
+
+//
+// Board values the Linux driver reads from DTS. A profile is stored as
+// REG_BINARY "Profile" in the device's hardware key, little endian and
+// laid out as below; tools/dts2profile.py builds one from a DTS node.
+//
+#define AW8624_PROFILE_SIGNATURE 0x46505741 // "AWPF"
+#define AW8624_PROFILE_VERSION 1
+
+typedef struct _AW8624_PROFILE
+{
+	ULONG Signature;
+	ULONG Version;
+	ULONG F0Preset;			// vib_f0_pre, in 0.1 Hz
+	ULONG F0Coeff;			// vib_f0_coeff
+	UINT16 ContTd;			// vib_cont_td
+	UINT16 ContZcThr;		// vib_cont_zc_thr
+	UINT8 ContDrvLvl;		// vib_cont_drv_lev
+	UINT8 ContDrvLvlOv;		// vib_cont_drv_lvl_ov
+	UINT8 ContNumBrk;		// vib_cont_num_brk
+	UINT8 Tset;				// vib_tset
+	UINT8 SwBrake;			// vib_sw_brake
+	UINT8 BemfConfig[4];	// vib_bemf_config
+	UINT8 Reserved[3];
+} AW8624_PROFILE, * PAW8624_PROFILE;
+
+C_ASSERT(sizeof(AW8624_PROFILE) == 32);
+
+//
+// Profile registers precompiled into the bursts they are written with
+//
+typedef struct _AW8624_PROFILE_IMAGE
 {
-	HWN_SETTINGS CurrentState;
-	struct _AW8624_HAPTICS_CURRENT_STATE* NextState;
-} AW8624_HAPTICS_CURRENT_STATE, * PAW8624_HAPTICS_CURRENT_STATE;
+	UCHAR Timing[5];		// F_PRE_H through TSET
+	UCHAR Bemf[6];			// ZC_THRSH_H through BEMF_VTHL_L
+	UCHAR Drive[3];			// TIME_NZC through DRV_LVL_OV
+} AW8624_PROFILE_IMAGE, * PAW8624_PROFILE_IMAGE;
 
 //
 // The device context performs the same job as
@@ -55,13 +209,116 @@ typedef struct _DEVICE_CONTEXT
 	//
 	SPB_CONTEXT I2CContext;
 
+	//
+	// Last known contents of the AW8624 register map
+	//
+	AW8624_REGISTER_CACHE RegisterCache;
+
+	//
+	// Set once the continuous mode parameters have been committed
+	// to the chip, cleared whenever the register map is reset
+	//
+	BOOLEAN ContinuousModePrepared;
+
+	//
+	// Board profile and the register image built from it
+	//
+	AW8624_PROFILE Profile;
+	AW8624_PROFILE_IMAGE ProfileImage;
+
+	//
+	// DRV_LVL and DRV_LVL_OV for each HWN_INTENSITY value
+	//
+	AW8624_DRIVE_LEVEL DriveLevels[AW8624_INTENSITY_LEVELS];
+
+	//
+	// Resonant frequency of the LRA in 0.1 Hz, measured once
+	// per unit and kept in the device's hardware key. It holds
+	// the DTS preset until Calibrated is set.
+	//
+	ULONG F0;
+	BOOLEAN Calibrated;
+
+	//
+	// TRIM_LRA code that brings the measured f0 onto the preset
+	//
+	UINT8 TrimLra;
+
+	//
+	// Waveform bank in the AW8624 SRAM. RamBankLoaded is set by the setup
+	// work item and read by HWN_ON, both under ControllerLock; until it
+	// is set HWN_ON plays in continuous mode.
+	//
+	BOOLEAN RamBankLoaded;
+	UINT16 RamBaseAddress;
+
+	//
+	// Calibration and the waveform bank upload, queued at the end of
+	// every initialization so neither holds up the device
+	//
+	WDFWORKITEM SetupWorkItem;
+
+	// Whether the last GO was issued in RAM mode, only meaningful while PlaybackActive
+	BOOLEAN RamPlayback;
+
+	//
+	// HWN_BLINK edge generator
+	//
+	AW8624_BLINK Blink;
+
+	//
+	// Serializes chip access between requests and background work
+	//
+	WDFWAITLOCK ControllerLock;
+
+	//
+	// Set-state requests waiting for the bus
+	//
+	AW8624_REQUEST_QUEUE RequestQueue;
+	ULONG FailedRequests;
+
+	//
+	// Playback completion, signalled from the DONE interrupt
+	//
+	KEVENT PlaybackDoneEvent;
+	volatile LONG PlaybackActive;
+	ULONG StopTimeouts;
+
+	//
+	// Set from the interrupt path when the chip needs re-initialization
+	//
+	volatile LONG RecoveryPending;
+
+	//
+	// D0 entries that found the chip intact, and those that
+	// restored it from the register cache
+	//
+	ULONG WarmResumes;
+	ULONG ColdResumes;
+
+	//
+	// Occurrences of each SYSINT bit, indexed by bit position
+	//
+	ULONG InterruptCounts[AW8624_SYSINT_COUNT];
+
 	//
 	// Number of vibration motors
 	//
 	USHORT NumberOfHapticsDevices;
 
-	PAW8624_HAPTICS_CURRENT_STATE CurrentStates;
+	//
+	// Last requested settings, indexed by HwN id
+	//
+	PHWN_SETTINGS CurrentStates;
+
+	//
+	// Last state applied to the chip, and the requests
+	// that matched it and needed no bus traffic
+	//
 	HWN_STATE PreviousState;
+	ULONG PreviousIntensity;
+	ULONG SkippedStops;
+	ULONG SkippedStarts;
 } DEVICE_CONTEXT, * PDEVICE_CONTEXT;
 
 //
@@ -54,4 +54,9 @@ HWN_CLIENT_GET_STATE AW8624HapticsGetState;
 EVT_WDF_INTERRUPT_ISR AW8624HapticsEvtInterruptIsr;
 EVT_WDF_INTERRUPT_DPC AW8624HapticsEvtInterruptDpc;
 
+VOID
+AW8624HapticsPublishStatistics(
+	PDEVICE_CONTEXT devContext
+);
+
 EXTERN_C_END
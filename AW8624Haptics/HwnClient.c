@@ -25,6 +25,7 @@ Environment:
 #endif
 
 #ifdef ALLOC_PRAGMA
+#pragma alloc_text (PAGE, AW8624HapticsPublishStatistics)
 #pragma alloc_text (PAGE, AW8624HapticsInitializeDevice)
 #pragma alloc_text (PAGE, AW8624HapticsUnInitializeDevice)
 #pragma alloc_text (PAGE, AW8624HapticsQueryDeviceInformation)
@@ -45,7 +46,67 @@ AW8624HapticsEvtInterruptIsr(
 	UNREFERENCED_PARAMETER(Interrupt);
 	UNREFERENCED_PARAMETER(MessageID);
 
-	return TRUE;
+	if (globalContext == NULL)
+	{
+		return FALSE;
+	}
+
+	//
+	// The interrupt is configured for passive handling,
+	// so the SPB bus can be accessed from here directly
+	//
+	return AW8624InterruptService(globalContext);
+}
+
+//
+// Publishes the set-state counters to the device's hardware key so they
+// can be read back without a debug build
+//
+VOID
+AW8624HapticsPublishStatistics(
+	PDEVICE_CONTEXT devContext
+)
+{
+	NTSTATUS status = STATUS_SUCCESS;
+	WDFKEY key = NULL;
+	DECLARE_CONST_UNICODE_STRING(acceptedName, L"RequestsAccepted");
+	DECLARE_CONST_UNICODE_STRING(collapsedName, L"RequestsCollapsed");
+	DECLARE_CONST_UNICODE_STRING(executedName, L"RequestsExecuted");
+	DECLARE_CONST_UNICODE_STRING(batchesName, L"RequestBatches");
+	DECLARE_CONST_UNICODE_STRING(failedName, L"FailedRequests");
+	DECLARE_CONST_UNICODE_STRING(skippedStopsName, L"SkippedStops");
+	DECLARE_CONST_UNICODE_STRING(skippedStartsName, L"SkippedStarts");
+
+	PAGED_CODE();
+
+	status = WdfDeviceOpenRegistryKey(
+		devContext->Device,
+		PLUGPLAY_REGKEY_DEVICE,
+		KEY_WRITE,
+		WDF_NO_OBJECT_ATTRIBUTES,
+		&key);
+
+	if (!NT_SUCCESS(status))
+	{
+#ifdef DEBUG
+		Trace(
+			TRACE_LEVEL_WARNING,
+			TRACE_HAPTICS,
+			"%!FUNC!: Error opening the hardware key - %!STATUS!",
+			status);
+#endif
+		return;
+	}
+
+	WdfRegistryAssignULong(key, (PUNICODE_STRING)&acceptedName, devContext->RequestQueue.Accepted);
+	WdfRegistryAssignULong(key, (PUNICODE_STRING)&collapsedName, devContext->RequestQueue.Collapsed);
+	WdfRegistryAssignULong(key, (PUNICODE_STRING)&executedName, devContext->RequestQueue.Executed);
+	WdfRegistryAssignULong(key, (PUNICODE_STRING)&batchesName, devContext->RequestQueue.Batches);
+	WdfRegistryAssignULong(key, (PUNICODE_STRING)&failedName, devContext->FailedRequests);
+	WdfRegistryAssignULong(key, (PUNICODE_STRING)&skippedStopsName, devContext->SkippedStops);
+	WdfRegistryAssignULong(key, (PUNICODE_STRING)&skippedStartsName, devContext->SkippedStarts);
+
+	WdfRegistryClose(key);
 }
 
 NTSTATUS
@@ -63,6 +124,11 @@ AW8624HapticsInitializeDevice(
 	BOOLEAN I2CDetected = FALSE;
 	BOOLEAN InterruptDetected = FALSE;
 	WDF_INTERRUPT_CONFIG interruptConfig;
+	WDF_WORKITEM_CONFIG workItemConfig;
+	WDF_OBJECT_ATTRIBUTES workItemAttributes;
+	WDF_WORKITEM_CONFIG requestWorkItemConfig;
+	WDF_WORKITEM_CONFIG blinkWorkItemConfig;
+	WDF_TIMER_CONFIG blinkTimerConfig;
 
 	PAGED_CODE();
 
@@ -76,6 +142,8 @@ AW8624HapticsInitializeDevice(
 	
 	devContext->Device = Device;
 
+	KeInitializeEvent(&devContext->PlaybackDoneEvent, NotificationEvent, FALSE);
+
 	//
 	// Get the resouce hub connection ID for our I2C driver
 	//
@@ -168,6 +236,113 @@ AW8624HapticsInitializeDevice(
 		goto exit;
 	}
 
+	status = WdfWaitLockCreate(WDF_NO_OBJECT_ATTRIBUTES, &devContext->ControllerLock);
+
+	if (!NT_SUCCESS(status))
+	{
+#ifdef DEBUG
+		Trace(
+			TRACE_LEVEL_ERROR,
+			TRACE_INIT,
+			"WdfWaitLockCreate failed %!STATUS!",
+			status);
+#endif
+		goto exit;
+	}
+
+	//
+	// Calibration and the waveform bank upload run off the initialization path
+	//
+	WDF_WORKITEM_CONFIG_INIT(&workItemConfig, AW8624SetupWorkItem);
+	WDF_OBJECT_ATTRIBUTES_INIT(&workItemAttributes);
+	workItemAttributes.ParentObject = Device;
+
+	status = WdfWorkItemCreate(&workItemConfig, &workItemAttributes, &devContext->SetupWorkItem);
+
+	if (!NT_SUCCESS(status))
+	{
+#ifdef DEBUG
+		Trace(
+			TRACE_LEVEL_ERROR,
+			TRACE_INIT,
+			"WdfWorkItemCreate failed %!STATUS!",
+			status);
+#endif
+		goto exit;
+	}
+
+	//
+	// Set-state requests are executed by a single worker
+	//
+	status = WdfWaitLockCreate(WDF_NO_OBJECT_ATTRIBUTES, &devContext->RequestQueue.Lock);
+
+	if (!NT_SUCCESS(status))
+	{
+#ifdef DEBUG
+		Trace(
+			TRACE_LEVEL_ERROR,
+			TRACE_INIT,
+			"WdfWaitLockCreate failed %!STATUS!",
+			status);
+#endif
+		goto exit;
+	}
+
+	WDF_WORKITEM_CONFIG_INIT(&requestWorkItemConfig, AW8624HapticsRequestWorkItem);
+
+	status = WdfWorkItemCreate(&requestWorkItemConfig, &workItemAttributes, &devContext->RequestQueue.WorkItem);
+
+	if (!NT_SUCCESS(status))
+	{
+#ifdef DEBUG
+		Trace(
+			TRACE_LEVEL_ERROR,
+			TRACE_INIT,
+			"WdfWorkItemCreate failed %!STATUS!",
+			status);
+#endif
+		goto exit;
+	}
+
+	//
+	// HWN_BLINK edges are timed by a high resolution timer
+	// and applied to the chip from a work item
+	//
+	WDF_WORKITEM_CONFIG_INIT(&blinkWorkItemConfig, AW8624BlinkWorkItem);
+
+	status = WdfWorkItemCreate(&blinkWorkItemConfig, &workItemAttributes, &devContext->Blink.WorkItem);
+
+	if (!NT_SUCCESS(status))
+	{
+#ifdef DEBUG
+		Trace(
+			TRACE_LEVEL_ERROR,
+			TRACE_INIT,
+			"WdfWorkItemCreate failed %!STATUS!",
+			status);
+#endif
+		goto exit;
+	}
+
+	WDF_TIMER_CONFIG_INIT(&blinkTimerConfig, AW8624BlinkTimer);
+	blinkTimerConfig.UseHighResolutionTimer = WdfTrue;
+
+	status = WdfTimerCreate(&blinkTimerConfig, &workItemAttributes, &devContext->Blink.Timer);
+
+	if (!NT_SUCCESS(status))
+	{
+#ifdef DEBUG
+		Trace(
+			TRACE_LEVEL_ERROR,
+			TRACE_INIT,
+			"WdfTimerCreate failed %!STATUS!",
+			status);
+#endif
+		goto exit;
+	}
+
+	AW8624LoadProfile(devContext);
+
 	status = AW8624Initialize(devContext);
 
 	if (!NT_SUCCESS(status))
@@ -184,6 +359,20 @@ AW8624HapticsInitializeDevice(
 
 	devContext->NumberOfHapticsDevices = 1;
 
+	status = AW8624HapticsInitializeDeviceState(devContext);
+
+	if (!NT_SUCCESS(status))
+	{
+#ifdef DEBUG
+		Trace(
+			TRACE_LEVEL_ERROR,
+			TRACE_INIT,
+			"Error allocating HwN state - %!STATUS!",
+			status);
+#endif
+		goto exit;
+	}
+
 exit:
 	return status;
 }
@@ -202,20 +391,47 @@ AW8624HapticsUnInitializeDevice(
 	Trace(TRACE_LEVEL_INFORMATION, TRACE_DRIVER, "%!FUNC! Entry");
 #endif
 
-	PAW8624_HAPTICS_CURRENT_STATE currentState = NULL;
-	PAW8624_HAPTICS_CURRENT_STATE stateToFree = NULL;
-
 	PDEVICE_CONTEXT devContext = (PDEVICE_CONTEXT)Context;
 
-	currentState = devContext->CurrentStates;
+	if (devContext->RequestQueue.WorkItem != NULL)
+	{
+		WdfWorkItemFlush(devContext->RequestQueue.WorkItem);
+	}
+
+	if (devContext->Blink.Timer != NULL)
+	{
+		InterlockedExchange(&devContext->Blink.Active, FALSE);
+		WdfTimerStop(devContext->Blink.Timer, TRUE);
+		WdfWorkItemFlush(devContext->Blink.WorkItem);
+	}
+
+	if (devContext->SetupWorkItem != NULL)
+	{
+		WdfWorkItemFlush(devContext->SetupWorkItem);
+	}
 
-	while (currentState != NULL)
+	if (devContext->CurrentStates != NULL)
 	{
-		stateToFree = currentState;
-		currentState = currentState->NextState;
-		ExFreePoolWithTag(stateToFree, HAPTICS_POOL_TAG);
+		ExFreePoolWithTag(devContext->CurrentStates, HAPTICS_POOL_TAG);
+		devContext->CurrentStates = NULL;
 	}
 
+#ifdef DEBUG
+	Trace(
+		TRACE_LEVEL_INFORMATION,
+		TRACE_HAPTICS,
+		"%!FUNC!: %lu set-state requests, %lu collapsed, %lu executed in %lu batches, %lu failed, %lu stops and %lu starts skipped",
+		devContext->RequestQueue.Accepted,
+		devContext->RequestQueue.Collapsed,
+		devContext->RequestQueue.Executed,
+		devContext->RequestQueue.Batches,
+		devContext->FailedRequests,
+		devContext->SkippedStops,
+		devContext->SkippedStarts);
+#endif
+
+	AW8624HapticsPublishStatistics(devContext);
+
 	SpbTargetDeinitialize(Device, &devContext->I2CContext);
 
 	return status;
@@ -260,15 +476,43 @@ AW8624HapticsStartDevice(
 	__in PVOID Context
 )
 {
-	UNREFERENCED_PARAMETER(Context);
 	NTSTATUS status = STATUS_SUCCESS;
+	BOOLEAN pending = FALSE;
 
 	PAGED_CODE();
 
+	PDEVICE_CONTEXT devContext = (PDEVICE_CONTEXT)Context;
+	PAW8624_REQUEST_QUEUE queue = &devContext->RequestQueue;
+
 #ifdef DEBUG
 	Trace(TRACE_LEVEL_INFORMATION, TRACE_DRIVER, "%!FUNC! Entry");
 #endif
 
+	WdfWaitLockAcquire(devContext->ControllerLock, NULL);
+	status = AW8624Resume(devContext);
+	WdfWaitLockRelease(devContext->ControllerLock);
+
+	// Requests that arrived outside D0 run now
+	WdfWaitLockAcquire(queue->Lock, NULL);
+	queue->Stopped = FALSE;
+	pending = queue->PendingCount > 0;
+	WdfWaitLockRelease(queue->Lock);
+
+	if (pending)
+	{
+		WdfWorkItemEnqueue(queue->WorkItem);
+	}
+
+#ifdef DEBUG
+	Trace(
+		TRACE_LEVEL_INFORMATION,
+		TRACE_DRIVER,
+		"%!FUNC!: %lu warm and %lu cold resumes - %!STATUS!",
+		devContext->WarmResumes,
+		devContext->ColdResumes,
+		status);
+#endif
+
 	return status;
 }
 
@@ -277,18 +521,74 @@ AW8624HapticsStopDevice(
 	__in PVOID Context
 )
 {
-	UNREFERENCED_PARAMETER(Context);
 	NTSTATUS status = STATUS_SUCCESS;
 
 	PAGED_CODE();
 
+	PDEVICE_CONTEXT devContext = (PDEVICE_CONTEXT)Context;
+	PAW8624_REQUEST_QUEUE queue = &devContext->RequestQueue;
+
 #ifdef DEBUG
 	Trace(TRACE_LEVEL_INFORMATION, TRACE_DRIVER, "%!FUNC! Entry");
 #endif
 
+	//
+	// Hold back new requests, then let whatever the workers are already
+	// doing finish before the chip is put to standby
+	//
+	WdfWaitLockAcquire(queue->Lock, NULL);
+	queue->Stopped = TRUE;
+	WdfWaitLockRelease(queue->Lock);
+
+	WdfWorkItemFlush(queue->WorkItem);
+	WdfWorkItemFlush(devContext->SetupWorkItem);
+
+	WdfWaitLockAcquire(devContext->ControllerLock, NULL);
+	status = AW8624Suspend(devContext);
+	WdfWaitLockRelease(devContext->ControllerLock);
+
+	// An unresponsive chip must not hold up D0 exit
+	if (!NT_SUCCESS(status))
+	{
+#ifdef DEBUG
+		Trace(
+			TRACE_LEVEL_WARNING,
+			TRACE_DRIVER,
+			"%!FUNC!: Error stopping playback - %!STATUS!",
+			status);
+#endif
+		status = STATUS_SUCCESS;
+	}
+
+	AW8624HapticsPublishStatistics(devContext);
+
 	return status;
 }
 
+VOID
+AW8624HapticsSetStateCompletion(
+	PDEVICE_CONTEXT devContext,
+	PHWN_SETTINGS hwnSettings,
+	NTSTATUS Status
+)
+{
+	UNREFERENCED_PARAMETER(hwnSettings);
+
+	if (!NT_SUCCESS(Status))
+	{
+		devContext->FailedRequests++;
+
+#ifdef DEBUG
+		Trace(
+			TRACE_LEVEL_ERROR,
+			TRACE_HAPTICS,
+			"Error applying state to HwN %lu - %!STATUS!",
+			hwnSettings->HwNId,
+			Status);
+#endif
+	}
+}
+
 #define NUMBER_OF_HWN_DEVICES(x) (x - HWN_HEADER_SIZE) / HWN_SETTINGS_SIZE
 #define EXTRA_BYTES_AFTER_HWN_DEVICES(x) ((x - HWN_HEADER_SIZE) % HWN_SETTINGS_SIZE)
 
@@ -346,15 +646,19 @@ AW8624HapticsSetState(
 
 	NumberOfHwnDevicesInBuffer = NUMBER_OF_HWN_DEVICES(BufferLength);
 
-	for (i = 0; i < NumberOfHwnDevicesInBuffer; i++)
+	// Queue the device settings, the bus sequences run on the request worker
+	status = AW8624HapticsQueueSetDevices(
+		devContext,
+		hwnHeader->HwNSettingsInfo,
+		NumberOfHwnDevicesInBuffer,
+		AW8624HapticsSetStateCompletion);
+	if (!NT_SUCCESS(status))
 	{
-		// Set device settings here
-		status = AW8624HapticsSetDevice(Context, &(hwnHeader->HwNSettingsInfo[i]));
-		if (!NT_SUCCESS(status))
-		{
-			goto exit;
-		}
+		goto exit;
+	}
 
+	for (i = 0; i < NumberOfHwnDevicesInBuffer; i++)
+	{
 		// Backup device settings somewhere to retrieve them later
 		status = AW8624HapticsSetCurrentDeviceState(devContext, &(hwnHeader->HwNSettingsInfo[i]), HWN_SETTINGS_SIZE);
 		if (!NT_SUCCESS(status))
@@ -23,28 +23,71 @@ Environment:
 #include "HwnDefs.tmh"
 #endif
 
+//
+// Called with ControllerLock held
+//
 NTSTATUS
 AW8624HapticsToggleVibrationMotor(
 	PDEVICE_CONTEXT devContext,
-	HWN_STATE hwnState,
-	ULONG* hwnIntensity
+	PHWN_SETTINGS hwnSettings
 )
 {
+	NTSTATUS Status = STATUS_SUCCESS;
+	HWN_STATE hwnState = hwnSettings->OffOnBlink;
+	ULONG* hwnIntensity = &(hwnSettings->HwNSettings[HWN_INTENSITY]);
+
 #ifdef DEBUG
 	Trace(TRACE_LEVEL_INFORMATION, TRACE_DRIVER, "%!FUNC! Entry");
 #endif
 
-	UNREFERENCED_PARAMETER(hwnIntensity);
+	Status = AW8624Recover(devContext);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
 
+	//
+	// Only issue the difference from what the chip is already doing.
+	// PlaybackActive is cleared by DONE and fault interrupts, so a
+	// motor that stopped on its own is never mistaken for running.
+	//
 	switch (hwnState) {
 	case HWN_OFF:
 	{
-		return AW8624Stop(devContext);
+		if (devContext->PreviousState == HWN_OFF && !devContext->PlaybackActive)
+		{
+			devContext->SkippedStops++;
+			return Status;
+		}
+
+		AW8624BlinkCancel(devContext);
+
+		Status = AW8624Stop(devContext);
 		break;
 	}
 	case HWN_ON:
 	{
-		return AW8624VibrateUntilStopped(devContext);
+		if (devContext->PreviousState == HWN_ON && devContext->PlaybackActive &&
+			devContext->PreviousIntensity == *hwnIntensity)
+		{
+			devContext->SkippedStarts++;
+			return Status;
+		}
+
+		AW8624BlinkCancel(devContext);
+
+		Status = AW8624Vibrate(devContext, *hwnIntensity);
+		break;
+	}
+	case HWN_BLINK:
+	{
+		Status = AW8624Blink(
+			devContext,
+			hwnSettings->HwNId,
+			hwnSettings->HwNSettings[HWN_PERIOD],
+			hwnSettings->HwNSettings[HWN_DUTY_CYCLE],
+			hwnSettings->HwNSettings[HWN_CYCLE_COUNT],
+			*hwnIntensity);
 		break;
 	}
 	default:
@@ -52,17 +95,25 @@ AW8624HapticsToggleVibrationMotor(
 		return STATUS_NOT_IMPLEMENTED;
 	}
 	}
+
+	if (NT_SUCCESS(Status))
+	{
+		devContext->PreviousState = hwnState;
+		devContext->PreviousIntensity = *hwnIntensity;
+	}
+
+	return Status;
 }
 
+//
+// Called with ControllerLock held
+//
 NTSTATUS
 AW8624HapticsSetDevice(
 	PDEVICE_CONTEXT devContext,
 	PHWN_SETTINGS hwnSettings
 )
 {
-	NTSTATUS Status = STATUS_SUCCESS;
-	UINT8 i = 0;
-
 #ifdef DEBUG
 	Trace(TRACE_LEVEL_INFORMATION, TRACE_DRIVER, "%!FUNC! Entry");
 #endif
@@ -77,16 +128,139 @@ AW8624HapticsSetDevice(
 		return STATUS_INVALID_PARAMETER;
 	}
 
-	for (i = 0; i < devContext->NumberOfHapticsDevices; i++)
+	return AW8624HapticsToggleVibrationMotor(devContext, hwnSettings);
+}
+
+NTSTATUS
+AW8624HapticsQueueSetDevices(
+	PDEVICE_CONTEXT devContext,
+	PHWN_SETTINGS hwnSettings,
+	ULONG hwnSettingsCount,
+	PFN_AW8624_REQUEST_COMPLETION Completion
+)
+{
+	PAW8624_REQUEST_QUEUE Queue = NULL;
+	PAW8624_REQUEST Request = NULL;
+	ULONG i = 0;
+
+	if (devContext == NULL || hwnSettings == NULL)
+	{
+		return STATUS_INVALID_PARAMETER;
+	}
+
+	//
+	// Validate the whole buffer before anything is queued, rejecting
+	// what AW8624HapticsSetDevice would while the caller still waits
+	//
+	for (i = 0; i < hwnSettingsCount; i++)
 	{
-		Status = AW8624HapticsToggleVibrationMotor(
-			devContext,
-			hwnSettings->OffOnBlink,
-			&(hwnSettings->HwNSettings[HWN_INTENSITY])
-		);
+		if (hwnSettings[i].HwNId >= (ULONG)devContext->NumberOfHapticsDevices ||
+			hwnSettings[i].HwNId >= AW8624_MAX_HWN_DEVICES)
+		{
+			return STATUS_INVALID_PARAMETER;
+		}
 	}
 
-	return Status;
+	Queue = &devContext->RequestQueue;
+
+	WdfWaitLockAcquire(Queue->Lock, NULL);
+
+	for (i = 0; i < hwnSettingsCount; i++)
+	{
+		Request = &Queue->Requests[hwnSettings[i].HwNId];
+
+		Queue->Accepted++;
+
+		//
+		// Last writer wins, a request that has not run yet is replaced
+		// and completes together with the one that superseded it
+		//
+		if (Request->Pending)
+		{
+			Queue->Collapsed++;
+		}
+		else
+		{
+			Request->Pending = TRUE;
+			Queue->PendingCount++;
+		}
+
+		Request->Settings = hwnSettings[i];
+		Request->Completion = Completion;
+	}
+
+	WdfWaitLockRelease(Queue->Lock);
+
+	WdfWorkItemEnqueue(Queue->WorkItem);
+
+	return STATUS_SUCCESS;
+}
+
+VOID
+AW8624HapticsRequestWorkItem(
+	WDFWORKITEM WorkItem
+)
+{
+	PDEVICE_CONTEXT devContext = DeviceGetContext(WdfWorkItemGetParentObject(WorkItem));
+	PAW8624_REQUEST_QUEUE Queue = &devContext->RequestQueue;
+	AW8624_REQUEST Batch[AW8624_MAX_HWN_DEVICES];
+	NTSTATUS Status[AW8624_MAX_HWN_DEVICES];
+	ULONG Count = 0;
+	ULONG i = 0;
+
+	for (;;)
+	{
+		//
+		// All devices live on one chip, so the batch is one bus session.
+		// ControllerLock is taken before the slots are drained so that a
+		// blink edge never sees a request as taken but not yet applied.
+		//
+		WdfWaitLockAcquire(devContext->ControllerLock, NULL);
+
+		//
+		// Take every pending slot at once, freeing them
+		// so requests arriving meanwhile refill them
+		//
+		WdfWaitLockAcquire(Queue->Lock, NULL);
+
+		Count = 0;
+
+		for (i = 0; i < AW8624_MAX_HWN_DEVICES && Queue->PendingCount > 0 && !Queue->Stopped; i++)
+		{
+			if (Queue->Requests[i].Pending)
+			{
+				Batch[Count++] = Queue->Requests[i];
+				Queue->Requests[i].Pending = FALSE;
+				Queue->PendingCount--;
+			}
+		}
+
+		WdfWaitLockRelease(Queue->Lock);
+
+		if (Count == 0)
+		{
+			WdfWaitLockRelease(devContext->ControllerLock);
+			break;
+		}
+
+		for (i = 0; i < Count; i++)
+		{
+			Status[i] = AW8624HapticsSetDevice(devContext, &Batch[i].Settings);
+		}
+
+		WdfWaitLockRelease(devContext->ControllerLock);
+
+		Queue->Batches++;
+		Queue->Executed += Count;
+
+		for (i = 0; i < Count; i++)
+		{
+			if (Batch[i].Completion != NULL)
+			{
+				Batch[i].Completion(devContext, &Batch[i].Settings, Status[i]);
+			}
+		}
+	}
 }
 
 NTSTATUS
@@ -95,43 +269,50 @@ AW8624HapticsInitializeDeviceState(
 )
 {
 	NTSTATUS Status = STATUS_SUCCESS;
+	PHWN_SETTINGS HwNSettingsInfo = NULL;
+	USHORT j = 0;
 	UINT8 i = 0;
 
 #ifdef DEBUG
 	Trace(TRACE_LEVEL_INFORMATION, TRACE_DRIVER, "%!FUNC! Entry");
 #endif
 
-	if (devContext == NULL)
+	if (devContext == NULL || devContext->NumberOfHapticsDevices == 0)
 	{
 		return STATUS_INVALID_PARAMETER;
 	}
 
-	devContext->CurrentStates = (PAW8624_HAPTICS_CURRENT_STATE)ExAllocatePool2(
-		PagedPool,
-		sizeof(AW8624_HAPTICS_CURRENT_STATE),
+	//
+	// One entry per HwN id, allocated once so that
+	// requests never walk or allocate state storage
+	//
+	devContext->CurrentStates = (PHWN_SETTINGS)ExAllocatePool2(
+		POOL_FLAG_PAGED,
+		devContext->NumberOfHapticsDevices * sizeof(HWN_SETTINGS),
 		HAPTICS_POOL_TAG
 	);
 
 	if (devContext->CurrentStates)
 	{
-		PHWN_SETTINGS HwNSettingsInfo = &devContext->CurrentStates->CurrentState;
-
-		HwNSettingsInfo->HwNId = 0;
-		HwNSettingsInfo->HwNType = HWN_VIBRATOR;
-		HwNSettingsInfo->OffOnBlink = HWN_OFF;
-
-		for (i = 0; i < HWN_TOTAL_SETTINGS; i++)
+		for (j = 0; j < devContext->NumberOfHapticsDevices; j++)
 		{
-			HwNSettingsInfo->HwNSettings[i] = 0;
-		}
+			HwNSettingsInfo = &devContext->CurrentStates[j];
 
-		HwNSettingsInfo->HwNSettings[HWN_CURRENT_MTE_RESERVED] = HWN_CURRENT_MTE_NOT_SUPPORTED;
+			HwNSettingsInfo->HwNId = j;
+			HwNSettingsInfo->HwNType = HWN_VIBRATOR;
+			HwNSettingsInfo->OffOnBlink = HWN_OFF;
 
-		devContext->CurrentStates->NextState = NULL;
+			for (i = 0; i < HWN_TOTAL_SETTINGS; i++)
+			{
+				HwNSettingsInfo->HwNSettings[i] = 0;
+			}
+
+			HwNSettingsInfo->HwNSettings[HWN_CURRENT_MTE_RESERVED] = HWN_CURRENT_MTE_NOT_SUPPORTED;
+		}
 	}
 	else
 	{
-		Status = STATUS_UNSUCCESSFUL;
+		Status = STATUS_INSUFFICIENT_RESOURCES;
 	}
 
 	return Status;
@@ -150,46 +331,32 @@ AW8624HapticsGetCurrentDeviceState(
 	Trace(TRACE_LEVEL_INFORMATION, TRACE_DRIVER, "%!FUNC! Entry");
 #endif
 
-	if (devContext == NULL || hwnSettings == NULL)
+	if (devContext == NULL || hwnSettings == NULL || devContext->CurrentStates == NULL)
 	{
 		return STATUS_INVALID_PARAMETER;
 	}
 
-	PAW8624_HAPTICS_CURRENT_STATE currentState = devContext->CurrentStates;
-
-	if (!currentState)
+	if (hwnSettings->HwNId >= (ULONG)devContext->NumberOfHapticsDevices)
 	{
-		Status = AW8624HapticsInitializeDeviceState(devContext);
-		if (!NT_SUCCESS(Status))
-		{
-			return Status;
-		}
-		currentState = devContext->CurrentStates;
+		return STATUS_INVALID_PARAMETER;
 	}
 
-	while (currentState && (hwnSettings->HwNId != currentState->CurrentState.HwNId))
-	{
-		currentState = currentState->NextState;
-	}
+	// A finished blink pattern resets the state from the blink work item
+	WdfWaitLockAcquire(devContext->RequestQueue.Lock, NULL);
+
+	Status = memcpy_s(
+		(PVOID)hwnSettings,
+		HWN_SETTINGS_SIZE,
+		&devContext->CurrentStates[hwnSettings->HwNId],
+		hwnSettingsLength
+	);
 
-	if (!currentState)
+	WdfWaitLockRelease(devContext->RequestQueue.Lock);
+
+	if (!NT_SUCCESS(Status))
 	{
 		Status = STATUS_UNSUCCESSFUL;
 	}
-	else
-	{
-		Status = memcpy_s(
-			(PVOID)hwnSettings,
-			HWN_SETTINGS_SIZE,
-			&(currentState->CurrentState),
-			hwnSettingsLength
-		);
-
-		if (!NT_SUCCESS(Status))
-		{
-			Status = STATUS_UNSUCCESSFUL;
-		}
-	}
 
 	return Status;
 }
@@ -207,101 +374,34 @@ AW8624HapticsSetCurrentDeviceState(
 	Trace(TRACE_LEVEL_INFORMATION, TRACE_DRIVER, "%!FUNC! Entry");
 #endif
 
-	if (devContext == NULL || hwnSettings == NULL)
+	if (devContext == NULL || hwnSettings == NULL || devContext->CurrentStates == NULL)
 	{
 		return STATUS_INVALID_PARAMETER;
 	}
 
-	PAW8624_HAPTICS_CURRENT_STATE previousState = NULL;
-	PAW8624_HAPTICS_CURRENT_STATE currentState = devContext->CurrentStates;
+	if (hwnSettings->HwNId >= (ULONG)devContext->NumberOfHapticsDevices)
+	{
+		return STATUS_INVALID_PARAMETER;
+	}
 
 	hwnSettings->HwNSettings[HWN_CYCLE_GRANULARITY] = 0;
 	hwnSettings->HwNSettings[HWN_CURRENT_MTE_RESERVED] = HWN_CURRENT_MTE_NOT_SUPPORTED;
 
-	if (NULL == currentState)
-	{
-		devContext->CurrentStates = (PAW8624_HAPTICS_CURRENT_STATE)ExAllocatePool2(
-			PagedPool,
-			sizeof(AW8624_HAPTICS_CURRENT_STATE),
-			HAPTICS_POOL_TAG);
-
-		if (NULL != devContext->CurrentStates)
-		{
-			Status = memcpy_s(
-				&(devContext->CurrentStates->CurrentState),
-				HWN_SETTINGS_SIZE,
-				(PVOID)hwnSettings, hwnSettingsLength
-			);
+	WdfWaitLockAcquire(devContext->RequestQueue.Lock, NULL);
 
-			if (!NT_SUCCESS(Status))
-			{
-				Status = STATUS_UNSUCCESSFUL;
-			}
-			else
-			{
-				devContext->CurrentStates->NextState = NULL;
-			}
-		}
-		else
-		{
-			Status = STATUS_UNSUCCESSFUL;
-		}
-	}
-	else
-	{
-		while (currentState && (hwnSettings->HwNId != currentState->CurrentState.HwNId))
-		{
-			previousState = currentState;
-			currentState = currentState->NextState;
-		}
+	Status = memcpy_s(
+		&devContext->CurrentStates[hwnSettings->HwNId],
+		HWN_SETTINGS_SIZE,
+		(PVOID)hwnSettings,
+		hwnSettingsLength
+	);
 
-		if (currentState == NULL)
-		{
-			currentState = (PAW8624_HAPTICS_CURRENT_STATE)ExAllocatePool2(
-				PagedPool,
-				sizeof(AW8624_HAPTICS_CURRENT_STATE),
-				HAPTICS_POOL_TAG
-			);
+	WdfWaitLockRelease(devContext->RequestQueue.Lock);
 
-			if (currentState)
-			{
-				Status = memcpy_s(
-					&(currentState->CurrentState),
-					HWN_SETTINGS_SIZE,
-					(PVOID)hwnSettings,
-					hwnSettingsLength
-				);
-
-				if (!NT_SUCCESS(Status))
-				{
-					Status = STATUS_UNSUCCESSFUL;
-				}
-				else
-				{
-					previousState->NextState = currentState;
-					currentState->NextState = NULL;
-				}
-			}
-			else
-			{
-				Status = STATUS_UNSUCCESSFUL;
-			}
-		}
-		else
-		{
-			Status = memcpy_s(
-				&(currentState->CurrentState),
-				HWN_SETTINGS_SIZE,
-				(PVOID)hwnSettings,
-				hwnSettingsLength
-			);
-
-			if (!NT_SUCCESS(Status))
-			{
-				Status = STATUS_UNSUCCESSFUL;
-			}
-		}
+	if (!NT_SUCCESS(Status))
+	{
+		Status = STATUS_UNSUCCESSFUL;
 	}
 
 	return Status;
-}
\ No newline at end of file
+}
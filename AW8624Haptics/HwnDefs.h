@@ -25,6 +25,16 @@ AW8624HapticsSetDevice(
 	PHWN_SETTINGS hwnSettings
 );
 
+NTSTATUS
+AW8624HapticsQueueSetDevices(
+	PDEVICE_CONTEXT devContext,
+	PHWN_SETTINGS hwnSettings,
+	ULONG hwnSettingsCount,
+	PFN_AW8624_REQUEST_COMPLETION Completion
+);
+
+EVT_WDF_WORKITEM AW8624HapticsRequestWorkItem;
+
 NTSTATUS
 AW8624HapticsInitializeDeviceState(
 	PDEVICE_CONTEXT devContext
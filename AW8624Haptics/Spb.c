@@ -24,6 +24,7 @@
 
 #include "driver.h"
 #include "spb.h"
+#include <spb.h>
 
 #ifdef DEBUG
 #include <spb.tmh>
@@ -73,6 +74,8 @@ SpbDoWriteDataSynchronously(
 
 	if (length > DEFAULT_SPB_BUFFER_SIZE)
 	{
+		SpbContext->AllocationCount++;
+
 		status = WdfMemoryCreate(
 			WDF_NO_OBJECT_ATTRIBUTES,
 			NonPagedPool,
@@ -128,6 +131,8 @@ SpbDoWriteDataSynchronously(
 	DbgPrintEx(DPFLTR_IHVDRIVER_ID, DPFLTR_ERROR_LEVEL, "\n");
 #endif
 
+	SpbContext->TransferCount++;
+
 	status = WdfIoTargetSendWriteSynchronously(
 		SpbContext->SpbIoTarget,
 		NULL,
@@ -201,6 +206,112 @@ SpbWriteDataSynchronously(
 	return status;
 }
 
+NTSTATUS
+SpbWriteDataGathered(
+	IN SPB_CONTEXT* SpbContext,
+	IN UCHAR Address,
+	IN PSPB_WRITE_SEGMENT Segments,
+	IN ULONG SegmentCount
+)
+/*++
+
+  Routine Description:
+
+	This helper routine sends an I2C write whose payload is spread
+	over caller-owned buffers. The address byte and the segments are
+	described as one buffer list, so the controller transmits them as
+	a single write without the payload being copied first.
+
+  Arguments:
+
+	SpbContext   - Pointer to the current device context
+	Address      - The I2C register address to write to
+	Segments     - The buffers to write, in order
+	SegmentCount - The number of entries in Segments
+
+  Return Value:
+
+	NTSTATUS Status indicating success or failure
+
+--*/
+{
+	SPB_TRANSFER_BUFFER_LIST_ENTRY bufferList[1 + SPB_MAX_WRITE_SEGMENTS];
+	SPB_TRANSFER_LIST sequence;
+	WDF_MEMORY_DESCRIPTOR memoryDescriptor;
+	NTSTATUS status;
+	ULONG_PTR bytesWritten;
+	ULONG length;
+	ULONG i;
+
+	if (SegmentCount == 0 || SegmentCount > SPB_MAX_WRITE_SEGMENTS)
+	{
+		return STATUS_INVALID_PARAMETER;
+	}
+
+	//
+	// Transaction starts by specifying the address byte,
+	// followed by each segment of the payload
+	//
+	bufferList[0].Buffer = &Address;
+	bufferList[0].BufferCb = sizeof(Address);
+	length = sizeof(Address);
+
+	for (i = 0; i < SegmentCount; i++)
+	{
+		bufferList[i + 1].Buffer = Segments[i].Buffer;
+		bufferList[i + 1].BufferCb = Segments[i].Length;
+		length += Segments[i].Length;
+	}
+
+	SPB_TRANSFER_LIST_INIT(&sequence, 1);
+
+	sequence.Transfers[0] = SPB_TRANSFER_LIST_ENTRY_INIT_BUFFER_LIST(
+		SpbTransferDirectionToDevice,
+		0,
+		bufferList,
+		SegmentCount + 1);
+
+	WDF_MEMORY_DESCRIPTOR_INIT_BUFFER(
+		&memoryDescriptor,
+		(PVOID)&sequence,
+		sizeof(sequence));
+
+	bytesWritten = 0;
+
+	WdfWaitLockAcquire(SpbContext->SpbLock, NULL);
+
+	SpbContext->TransferCount++;
+
+	status = WdfIoTargetSendIoctlSynchronously(
+		SpbContext->SpbIoTarget,
+		NULL,
+		IOCTL_SPB_EXECUTE_SEQUENCE,
+		&memoryDescriptor,
+		NULL,
+		NULL,
+		&bytesWritten);
+
+	WdfWaitLockRelease(SpbContext->SpbLock);
+
+	if (NT_SUCCESS(status) && bytesWritten != length)
+	{
+		status = STATUS_DEVICE_PROTOCOL_ERROR;
+	}
+
+#ifdef DEBUG
+	if (!NT_SUCCESS(status))
+	{
+		Trace(
+			TRACE_LEVEL_ERROR,
+			TRACE_SPB,
+			"Error writing gathered buffers to Spb - 0x%08lX",
+			status);
+	}
+#endif
+
+	return status;
+}
+
 NTSTATUS
 SpbReadDataSynchronously(
 	IN SPB_CONTEXT* SpbContext,
@@ -213,7 +324,10 @@ SpbReadDataSynchronously(
   Routine Description:
 
 	This helper routine abstracts creating and sending an I/O
-	request (I2C Read) to the Spb I/O target.
+	request (I2C Read) to the Spb I/O target. The address pointer
+	write and the data read are issued as a single sequence, so the
+	controller joins them with a repeated start instead of releasing
+	the bus in between.
 
   Arguments:
 
@@ -231,6 +345,7 @@ SpbReadDataSynchronously(
 	PUCHAR buffer;
 	WDFMEMORY memory;
 	WDF_MEMORY_DESCRIPTOR memoryDescriptor;
+	SPB_TRANSFER_LIST_AND_ENTRIES(2) sequence;
 	NTSTATUS status;
 	ULONG_PTR bytesRead;
 
@@ -240,29 +355,10 @@ SpbReadDataSynchronously(
 	status = STATUS_INVALID_PARAMETER;
 	bytesRead = 0;
 
-	//
-	// Read transactions start by writing an address pointer
-	//
-	status = SpbDoWriteDataSynchronously(
-		SpbContext,
-		Address,
-		NULL,
-		0);
-
-	if (!NT_SUCCESS(status))
-	{
-#ifdef DEBUG
-		Trace(
-			TRACE_LEVEL_ERROR,
-			TRACE_SPB,
-			"Error setting address pointer for Spb read - 0x%08lX",
-			status);
-#endif
-		goto exit;
-	}
-
 	if (Length > DEFAULT_SPB_BUFFER_SIZE)
 	{
+		SpbContext->AllocationCount++;
+
 		status = WdfMemoryCreate(
 			WDF_NO_OBJECT_ATTRIBUTES,
 			NonPagedPool,
@@ -282,33 +378,52 @@ SpbReadDataSynchronously(
 #endif
 			goto exit;
 		}
-
-		WDF_MEMORY_DESCRIPTOR_INIT_HANDLE(
-			&memoryDescriptor,
-			memory,
-			NULL);
 	}
 	else
 	{
 		buffer = (PUCHAR)WdfMemoryGetBuffer(SpbContext->ReadMemory, NULL);
-
-		WDF_MEMORY_DESCRIPTOR_INIT_BUFFER(
-			&memoryDescriptor,
-			(PVOID)buffer,
-			Length);
 	}
 
+	//
+	// Read transactions start by writing an address pointer,
+	// followed by the data read within the same sequence
+	//
+	SPB_TRANSFER_LIST_INIT(&(sequence.List), 2);
+
+	sequence.List.Transfers[0] = SPB_TRANSFER_LIST_ENTRY_INIT_SIMPLE(
+		SpbTransferDirectionToDevice,
+		0,
+		&Address,
+		sizeof(Address));
+
+	sequence.List.Transfers[1] = SPB_TRANSFER_LIST_ENTRY_INIT_SIMPLE(
+		SpbTransferDirectionFromDevice,
+		0,
+		buffer,
+		Length);
+
+	WDF_MEMORY_DESCRIPTOR_INIT_BUFFER(
+		&memoryDescriptor,
+		(PVOID)&sequence,
+		sizeof(sequence));
+
+	SpbContext->TransferCount++;
 
-	status = WdfIoTargetSendReadSynchronously(
+	status = WdfIoTargetSendIoctlSynchronously(
 		SpbContext->SpbIoTarget,
 		NULL,
+		IOCTL_SPB_EXECUTE_SEQUENCE,
 		&memoryDescriptor,
 		NULL,
 		NULL,
 		&bytesRead);
 
-	if (!NT_SUCCESS(status) ||
-		bytesRead != Length)
+	if (NT_SUCCESS(status) && bytesRead != sizeof(Address) + Length)
+	{
+		status = STATUS_DEVICE_PROTOCOL_ERROR;
+	}
+
+	if (!NT_SUCCESS(status))
 	{
 #ifdef DEBUG
 		Trace(
@@ -490,8 +605,8 @@ SpbTargetInitialize(
 	}
 
 	//
-	// Allocate some fixed-size buffers from NonPagedPool for typical
-	// Spb transaction sizes to avoid pool fragmentation in most cases
+	// Allocate fixed-size buffers from NonPagedPool large enough for
+	// every burst the driver issues, so transfers never allocate
 	//
 	status = WdfMemoryCreate(
 		WDF_NO_OBJECT_ATTRIBUTES,
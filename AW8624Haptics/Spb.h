@@ -23,10 +23,17 @@
 #include <wdm.h>
 #include <wdf.h>
 
-#define DEFAULT_SPB_BUFFER_SIZE 64
+//
+// The default buffers hold the largest burst the driver issues, a RAM
+// bank chunk, plus its address byte. Only longer transfers allocate.
+//
+#define SPB_MAX_BURST_SIZE 256
+#define DEFAULT_SPB_BUFFER_SIZE (SPB_MAX_BURST_SIZE + 1)
 
 #define SPB_POOL_TAG 'bpSH'
 
+#define SPB_MAX_WRITE_SEGMENTS 1
+
 //
 // SPB (I2C) context
 //
@@ -38,8 +45,28 @@ typedef struct _SPB_CONTEXT
 	WDFMEMORY WriteMemory;
 	WDFMEMORY ReadMemory;
 	WDFWAITLOCK SpbLock;
+
+	//
+	// Number of bus transactions issued since initialization
+	//
+	ULONG TransferCount;
+
+	//
+	// Transfers too large for the default buffers, each of
+	// which needed a memory object of its own
+	//
+	ULONG AllocationCount;
 } SPB_CONTEXT;
 
+//
+// Caller-owned piece of a gathered write payload
+//
+typedef struct _SPB_WRITE_SEGMENT
+{
+	PVOID Buffer;
+	ULONG Length;
+} SPB_WRITE_SEGMENT, * PSPB_WRITE_SEGMENT;
+
 NTSTATUS
 SpbReadDataSynchronously(
 	IN SPB_CONTEXT* SpbContext,
@@ -66,4 +93,12 @@ SpbWriteDataSynchronously(
 	IN UCHAR Address,
 	IN PVOID Data,
 	IN ULONG Length
+);
+
+NTSTATUS
+SpbWriteDataGathered(
+	IN SPB_CONTEXT* SpbContext,
+	IN UCHAR Address,
+	IN PSPB_WRITE_SEGMENT Segments,
+	IN ULONG SegmentCount
 );
\ No newline at end of file
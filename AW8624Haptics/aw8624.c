@@ -44,6 +44,20 @@
 		return Status;											\
 	}
 
+#define AW8624WriteReg16WithCheck(Context, Address, Data)		\
+	Status = AW8624SpbWrite16(Context, Address, Data);			\
+	if (!NT_SUCCESS(Status))									\
+	{															\
+		return Status;											\
+	}
+
+#define AW8624WriteBurstWithCheck(Context, Address, Data, Length)	\
+	Status = AW8624SpbWriteBurst(Context, Address, Data, Length);	\
+	if (!NT_SUCCESS(Status))										\
+	{																\
+		return Status;												\
+	}
+
 #define AW8624WriteBitsWithCheck(Context, Address, Mask, Data)	\
 	Status = AW8624WriteBits(Context, Address, Mask, Data);		\
 	if (!NT_SUCCESS(Status))									\
@@ -51,11 +65,281 @@
 		return Status;											\
 	}
 
+//
+// H/L pairs are written as a single auto-increment burst, high byte first
+//
+C_ASSERT(AW8624_REG_BASE_ADDRL == AW8624_REG16_BASE_ADDR + 1);
+C_ASSERT(AW8624_REG_FIFO_AEL == AW8624_REG16_FIFO_AE + 1);
+C_ASSERT(AW8624_REG_FIFO_AFL == AW8624_REG16_FIFO_AF + 1);
+C_ASSERT(AW8624_REG_END_DLY_L == AW8624_REG16_END_DLY + 1);
+C_ASSERT(AW8624_REG_RAMADDRL == AW8624_REG16_RAMADDR + 1);
+C_ASSERT(AW8624_REG_F_PRE_L == AW8624_REG16_F_PRE + 1);
+C_ASSERT(AW8624_REG_TD_L == AW8624_REG16_TD + 1);
+C_ASSERT(AW8624_REG_EF_WDATAL == AW8624_REG16_EF_WDATA + 1);
+C_ASSERT(AW8624_REG_EF_RDATAL == AW8624_REG16_EF_RDATA + 1);
+C_ASSERT(AW8624_REG_F_LRA_F0_L == AW8624_REG16_F_LRA_F0 + 1);
+C_ASSERT(AW8624_REG_F_LRA_CONT_L == AW8624_REG16_F_LRA_CONT + 1);
+C_ASSERT(AW8624_REG_BEMF_VOL_L == AW8624_REG16_BEMF_VOL + 1);
+C_ASSERT(AW8624_REG_ZC_THRSH_L == AW8624_REG16_ZC_THRSH + 1);
+C_ASSERT(AW8624_REG_BEMF_VTHH_L == AW8624_REG16_BEMF_VTHH + 1);
+C_ASSERT(AW8624_REG_BEMF_VTHL_L == AW8624_REG16_BEMF_VTHL + 1);
+C_ASSERT(AW8624_REG_BEMF_VTHL_H == AW8624_REG_BEMF_VTHH_L + 1);
+C_ASSERT(AW8624_REG_BEMF_VTHH_H == AW8624_REG_ZC_THRSH_L + 1);
+C_ASSERT(AW8624_REG_TD_H == AW8624_REG_F_PRE_L + 1);
+C_ASSERT(AW8624_REG_TSET == AW8624_REG_TD_L + 1);
+C_ASSERT(AW8624_REG_DRV_LVL_OV == AW8624_REG_TIME_NZC + 2);
+
+#define AW8624CommitWithCheck(Context, Transaction)				\
+	Status = AW8624TransactionCommit(Context, Transaction);		\
+	if (!NT_SUCCESS(Status))									\
+	{															\
+		return Status;											\
+	}
+
+#define AW8624_MAX_TRANSACTION_UPDATES			16
+
+//
+// Time allowed for the DONE interrupt after GO is cleared, before
+// falling back to polling GLB_STATE
+//
+#define AW8624_STOP_TIMEOUT_MS					50
+#define AW8624_STOP_POLL_COUNT					100
+
+// Plausible LRA resonance, 100 Hz to 300 Hz
+#define AW8624_F0_MIN							1000
+#define AW8624_F0_MAX							3000
+
+// Calibration results, kept in the device's hardware key
+#define AW8624_F0_VALUE_NAME					L"F0"
+#define AW8624_TRIM_LRA_VALUE_NAME				L"TrimLra"
+
+// TRIM_LRA is a signed code in 0.25% steps, encoded as in the vendor driver
+#define AW8624_TRIM_LRA_MIN						(-16)
+#define AW8624_TRIM_LRA_MAX						15
+#define AW8624_TRIM_LRA_CODE_MASK				0x1F
+#define AW8624_TRIM_LRA_STEPS_PER_UNIT			400
+#define AW8624_TRIM_MAX_MEASUREMENTS			5
+
+#define AW8624_F0_DETECT_POLL_MS				10
+#define AW8624_F0_DETECT_POLL_COUNT				50
+
+#define AW8624_PROFILE_VALUE_NAME				L"Profile"
+
+#define AW8624_TIME_NZC							0x23
+
+// Brake periods, the low nibble of BEMF_NUM
+#define AW8624_CONT_NUM_BRK_MAX					0xF
+
+//
+// Registers checked on D0 entry to tell whether the chip kept its
+// state. F_PRE through TSET hold calibrated and profile values once
+// continuous mode has been prepared, a reset chip will not match them.
+//
+#define AW8624_RESUME_SIGNATURE					AW8624_REG_F_PRE_H
+#define AW8624_RESUME_SIGNATURE_LENGTH			5
+
+//
+// Waveform bank layout, as consumed by the Linux driver:
+// a 16-bit big-endian checksum of everything after it, the
+// 16-bit big-endian SRAM base address, then the SRAM contents
+//
+#define AW8624_RAM_BANK_PATH					L"\\SystemRoot\\System32\\drivers\\aw8624_haptic.bin"
+#define AW8624_RAM_BANK_HEADER_SIZE				4
+#define AW8624_RAM_BANK_MAX_SIZE				(8 * 1024)
+#define AW8624_SRAM_SIZE						(8 * 1024)
+#define AW8624_RAM_CHUNK_SIZE					256
+
+// Bank waveform HWN_ON loops, and the DATDBG gain that plays it unscaled
+#define AW8624_RAM_CONTINUOUS_EFFECT			1
+#define AW8624_RAM_GAIN_MAX						0x80
+
+// WAVSEQ1 through MAIN_LOOP
+#define AW8624_EFFECT_CHAIN_IMAGE_SIZE			(AW8624_REG_MAIN_LOOP - AW8624_REG_WAVSEQ1 + 1)
+
+C_ASSERT(AW8624_REG_WAVLOOP1 == AW8624_REG_WAVSEQ1 + AW8624_EFFECT_CHAIN_STEPS);
+C_ASSERT(AW8624_REG_MAIN_LOOP == AW8624_REG_WAVLOOP1 + AW8624_EFFECT_CHAIN_STEPS / 2);
+
+C_ASSERT(AW8624_RAM_CHUNK_SIZE <= SPB_MAX_BURST_SIZE);
+
+//
+// Xiaomi 11 Lite 5G NE, used when the hardware key carries no profile
+//
+static const AW8624_PROFILE AW8624DefaultProfile =
+{
+	AW8624_PROFILE_SIGNATURE,
+	AW8624_PROFILE_VERSION,
+	2050,						// vib_f0_pre
+	260,						// vib_f0_coeff
+	0xF06C,						// vib_cont_td
+	0x8F8,						// vib_cont_zc_thr
+	0x6B,						// vib_cont_drv_lev
+	0x9B,						// vib_cont_drv_lvl_ov
+	0x03,						// vib_cont_num_brk
+	0x11,						// vib_tset
+	0x2C,						// vib_sw_brake
+	{ 0x00, 0x08, 0x03, 0xF8 },	// vib_bemf_config
+	{ 0 }
+};
+
+typedef VOID AW8624_INTERRUPT_HANDLER(PDEVICE_CONTEXT pDevice);
+
+typedef struct _AW8624_INTERRUPT_DISPATCH
+{
+	UINT8 Bit;
+	AW8624_INTERRUPT_HANDLER* Handler;
+} AW8624_INTERRUPT_DISPATCH;
+
+//
+// A pending read-modify-write of a single register. Mask holds the
+// bits to preserve from the current register contents, as with
+// AW8624WriteBits.
+//
+typedef struct _AW8624_REG_UPDATE
+{
+	UCHAR Address;
+	INT32 Mask;
+	UINT8 Value;
+} AW8624_REG_UPDATE, * PAW8624_REG_UPDATE;
+
+//
+// Bit updates collected between AW8624TransactionBegin and
+// AW8624TransactionCommit, merged so that every touched register
+// is written exactly once, in order of first use.
+//
+typedef struct _AW8624_REG_TRANSACTION
+{
+	ULONG Count;
+	BOOLEAN Overflow;
+	AW8624_REG_UPDATE Updates[AW8624_MAX_TRANSACTION_UPDATES];
+} AW8624_REG_TRANSACTION, * PAW8624_REG_TRANSACTION;
+
+//
+// Bit updates indexed by address, written back as one burst per run
+// of contiguous registers rather than one transfer per register
+//
+typedef struct _AW8624_REG_PLAN
+{
+	BOOLEAN Present[AW8624_REGISTER_COUNT];
+	UINT8 Mask[AW8624_REGISTER_COUNT];
+	UINT8 Value[AW8624_REGISTER_COUNT];
+	ULONG Registers;
+	ULONG Bursts;
+} AW8624_REG_PLAN, * PAW8624_REG_PLAN;
+
+BOOLEAN
+AW8624IsVolatileRegister(
+	UCHAR Address
+)
+{
+	switch (Address)
+	{
+	// Writing the ID register soft resets the chip
+	case AW8624_REG_ID:
+	// Status and interrupt flags, cleared on read
+	case AW8624_REG_SYSST:
+	case AW8624_REG_SYSINT:
+	// Cleared by the chip once playback ends
+	case AW8624_REG_GO:
+	// FIFO and SRAM data ports, and the SRAM pointer they advance
+	case AW8624_REG_RTP_DATA:
+	case AW8624_REG_RAMADDRH:
+	case AW8624_REG_RAMADDRL:
+	case AW8624_REG_RAMDATA:
+	// Live state and measurement results
+	case AW8624_REG_DBGSTAT:
+	case AW8624_REG_GLB_STATE:
+	case AW8624_REG_EF_RDATAH:
+	case AW8624_REG_EF_RDATAL:
+	case AW8624_REG_RLDET:
+	case AW8624_REG_OSDET:
+	case AW8624_REG_VBATDET:
+	case AW8624_REG_TESTDET:
+	case AW8624_REG_F_LRA_F0_H:
+	case AW8624_REG_F_LRA_F0_L:
+	case AW8624_REG_F_LRA_CONT_H:
+	case AW8624_REG_F_LRA_CONT_L:
+	case AW8624_REG_BEMF_VOL_H:
+	case AW8624_REG_BEMF_VOL_L:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+BOOLEAN
+AW8624IsDataPort(
+	UCHAR Address
+)
+{
+	// Bursts to a data port do not advance the register address
+	return Address == AW8624_REG_RTP_DATA || Address == AW8624_REG_RAMDATA;
+}
+
+VOID
+AW8624CacheInvalidate(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	RtlZeroMemory(pDevice->RegisterCache.Valid, sizeof(pDevice->RegisterCache.Valid));
+}
+
+BOOLEAN
+AW8624CacheLookup(
+	PDEVICE_CONTEXT pDevice,
+	UCHAR Address,
+	PUCHAR Data,
+	ULONG Length
+)
+{
+	PAW8624_REGISTER_CACHE Cache = &pDevice->RegisterCache;
+	ULONG i = 0;
+
+	for (i = Address; i < Address + Length; i++)
+	{
+		if (i > AW8624_REG_MAX || AW8624IsVolatileRegister((UCHAR)i) || !Cache->Valid[i])
+		{
+			Cache->Misses++;
+			return FALSE;
+		}
+	}
+
+	RtlCopyMemory(Data, &Cache->Value[Address], Length);
+	Cache->Hits++;
+
+	return TRUE;
+}
+
+VOID
+AW8624CacheUpdate(
+	PDEVICE_CONTEXT pDevice,
+	UCHAR Address,
+	PUCHAR Data,
+	ULONG Length
+)
+{
+	PAW8624_REGISTER_CACHE Cache = &pDevice->RegisterCache;
+	ULONG i = 0;
+
+	if (AW8624IsDataPort(Address))
+	{
+		return;
+	}
+
+	for (i = Address; i < Address + Length; i++)
+	{
+		if (i <= AW8624_REG_MAX && !AW8624IsVolatileRegister((UCHAR)i))
+		{
+			Cache->Value[i] = Data[i - Address];
+			Cache->Valid[i] = TRUE;
+		}
+	}
+}
+
 NTSTATUS
 AW8624SpbRead(
 	PDEVICE_CONTEXT pDevice,
 	UCHAR Address,
-	PUINT16 Data,
+	PUCHAR Data,
 	ULONG Length
 )
 {
@@ -63,6 +347,11 @@ AW8624SpbRead(
 
 	Status = SpbReadDataSynchronously(&pDevice->I2CContext, Address, (PVOID)Data, Length);
 
+	if (NT_SUCCESS(Status))
+	{
+		AW8624CacheUpdate(pDevice, Address, Data, Length);
+	}
+
 #ifdef DEBUG
 	if (!NT_SUCCESS(Status))
 	{
@@ -78,15 +367,29 @@ AW8624SpbRead(
 }
 
 NTSTATUS
-AW8624SpbWrite(
+AW8624SpbWriteBurst(
 	PDEVICE_CONTEXT pDevice,
 	UCHAR Address,
-	UINT16 Data
+	PUCHAR Data,
+	ULONG Length
 )
 {
 	NTSTATUS Status = STATUS_SUCCESS;
 
-	Status = SpbWriteDataSynchronously(&pDevice->I2CContext, Address, (PVOID)&Data, sizeof(Data));
+	// The register address auto-increments, so Data[i] lands in Address + i
+	Status = SpbWriteDataSynchronously(&pDevice->I2CContext, Address, (PVOID)Data, Length);
+
+	if (Address == AW8624_REG_ID)
+	{
+		// Any write to the ID register resets the register map
+		AW8624CacheInvalidate(pDevice);
+		pDevice->ContinuousModePrepared = FALSE;
+		pDevice->RamBankLoaded = FALSE;
+	}
+	else if (NT_SUCCESS(Status))
+	{
+		AW8624CacheUpdate(pDevice, Address, Data, Length);
+	}
 
 #ifdef DEBUG
 	if (!NT_SUCCESS(Status))
@@ -102,6 +405,32 @@ AW8624SpbWrite(
 	return Status;
 }
 
+NTSTATUS
+AW8624SpbWrite(
+	PDEVICE_CONTEXT pDevice,
+	UCHAR Address,
+	UINT8 Data
+)
+{
+	return AW8624SpbWriteBurst(pDevice, Address, &Data, sizeof(Data));
+}
+
+NTSTATUS
+AW8624SpbWrite16(
+	PDEVICE_CONTEXT pDevice,
+	UCHAR Address,
+	UINT16 Data
+)
+{
+	UCHAR Buffer[2];
+
+	// 16-bit values are split over an H/L register pair, high byte first
+	Buffer[0] = (UCHAR)(Data >> 8);
+	Buffer[1] = (UCHAR)(Data & 0xFF);
+
+	return AW8624SpbWriteBurst(pDevice, Address, Buffer, sizeof(Buffer));
+}
+
 NTSTATUS
 AW8624WriteBits(
 	PDEVICE_CONTEXT pDevice,
@@ -110,13 +439,238 @@ AW8624WriteBits(
 	UINT8 Value
 )
 {
-	UINT16 RegData = 0;
+	UINT8 RegData = 0;
+	UINT8 NewData = 0;
+	NTSTATUS Status = STATUS_SUCCESS;
+
+	if (!AW8624CacheLookup(pDevice, Address, &RegData, sizeof(RegData)))
+	{
+		AW8624ReadRegWithCheck(pDevice, Address, &RegData, sizeof(RegData));
+	}
+
+	NewData = (UINT8)((RegData & Mask) | Value);
+
+	// Skip the write when the chip already holds this value
+	if (NewData == RegData && !AW8624IsVolatileRegister(Address))
+	{
+		return Status;
+	}
+
+	AW8624WriteRegWithCheck(pDevice, Address, NewData);
+
+	return Status;
+}
+
+VOID
+AW8624TransactionBegin(
+	PAW8624_REG_TRANSACTION Transaction
+)
+{
+	Transaction->Count = 0;
+	Transaction->Overflow = FALSE;
+}
+
+VOID
+AW8624TransactionSetBits(
+	PAW8624_REG_TRANSACTION Transaction,
+	UCHAR Address,
+	INT32 Mask,
+	UINT8 Value
+)
+{
+	PAW8624_REG_UPDATE Update = NULL;
+	ULONG i = 0;
+
+	for (i = 0; i < Transaction->Count; i++)
+	{
+		Update = &Transaction->Updates[i];
+
+		if (Update->Address == Address)
+		{
+			Update->Mask &= Mask;
+			Update->Value = (UINT8)((Update->Value & Mask) | Value);
+			return;
+		}
+	}
+
+	if (Transaction->Count == AW8624_MAX_TRANSACTION_UPDATES)
+	{
+		Transaction->Overflow = TRUE;
+		return;
+	}
+
+	Update = &Transaction->Updates[Transaction->Count++];
+	Update->Address = Address;
+	Update->Mask = Mask;
+	Update->Value = Value;
+}
+
+NTSTATUS
+AW8624TransactionCommit(
+	PDEVICE_CONTEXT pDevice,
+	PAW8624_REG_TRANSACTION Transaction
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	PAW8624_REG_UPDATE Update = NULL;
+	ULONG i = 0;
+
+	if (Transaction->Overflow)
+	{
+#ifdef DEBUG
+		Trace(
+			TRACE_LEVEL_ERROR,
+			TRACE_SPB,
+			"Register transaction exceeds %d registers",
+			AW8624_MAX_TRANSACTION_UPDATES);
+#endif
+		return STATUS_INSUFFICIENT_RESOURCES;
+	}
+
+	for (i = 0; i < Transaction->Count; i++)
+	{
+		Update = &Transaction->Updates[i];
+		AW8624WriteBitsWithCheck(pDevice, Update->Address, Update->Mask, Update->Value);
+	}
+
+	Transaction->Count = 0;
+
+	return Status;
+}
+
+VOID
+AW8624PlanBegin(
+	PAW8624_REG_PLAN Plan
+)
+{
+	RtlZeroMemory(Plan, sizeof(*Plan));
+}
+
+VOID
+AW8624PlanSetBits(
+	PAW8624_REG_PLAN Plan,
+	UCHAR Address,
+	INT32 Mask,
+	UINT8 Value
+)
+{
+	if (!Plan->Present[Address])
+	{
+		Plan->Present[Address] = TRUE;
+		Plan->Mask[Address] = (UINT8)Mask;
+		Plan->Value[Address] = Value;
+		return;
+	}
+
+	Plan->Mask[Address] &= (UINT8)Mask;
+	Plan->Value[Address] = (UINT8)((Plan->Value[Address] & Mask) | Value);
+}
+
+NTSTATUS
+AW8624PlanWriteRun(
+	PDEVICE_CONTEXT pDevice,
+	PAW8624_REG_PLAN Plan,
+	UCHAR First,
+	ULONG Length
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	UCHAR Data[AW8624_REGISTER_COUNT];
+	BOOLEAN Cached[AW8624_REGISTER_COUNT];
+	ULONG ReadFirst = Length;
+	ULONG ReadLast = 0;
+	BOOLEAN ReadVolatile = FALSE;
+	BOOLEAN Changed = FALSE;
+	UINT8 NewData = 0;
+	ULONG i = 0;
+
+	//
+	// Only registers keeping some of their bits need current contents,
+	// those missing from the cache are fetched with a single read when
+	// the span holds nothing that reacts to being read
+	//
+	for (i = 0; i < Length; i++)
+	{
+		Cached[i] = AW8624CacheLookup(pDevice, (UCHAR)(First + i), &Data[i], 1);
+
+		if (!Cached[i] && Plan->Mask[First + i] != 0)
+		{
+			ReadFirst = min(ReadFirst, i);
+			ReadLast = i;
+		}
+	}
+
+	for (i = ReadFirst; i <= ReadLast && ReadFirst < Length; i++)
+	{
+		ReadVolatile |= AW8624IsVolatileRegister((UCHAR)(First + i));
+	}
+
+	if (ReadFirst < Length && !ReadVolatile)
+	{
+		AW8624ReadRegWithCheck(pDevice, (UCHAR)(First + ReadFirst), &Data[ReadFirst], ReadLast - ReadFirst + 1);
+	}
+	else if (ReadFirst < Length)
+	{
+		for (i = ReadFirst; i <= ReadLast; i++)
+		{
+			if (!Cached[i] && Plan->Mask[First + i] != 0)
+			{
+				AW8624ReadRegWithCheck(pDevice, (UCHAR)(First + i), &Data[i], 1);
+			}
+		}
+	}
+
+	for (i = 0; i < Length; i++)
+	{
+		NewData = (UINT8)((Data[i] & Plan->Mask[First + i]) | Plan->Value[First + i]);
+		Changed |= !Cached[i] || NewData != Data[i];
+		Data[i] = NewData;
+	}
+
+	// Skip the run when the chip already holds all of it
+	if (!Changed)
+	{
+		return Status;
+	}
+
+	AW8624WriteBurstWithCheck(pDevice, First, Data, Length);
+	Plan->Bursts++;
+
+	return Status;
+}
+
+NTSTATUS
+AW8624PlanCommit(
+	PDEVICE_CONTEXT pDevice,
+	PAW8624_REG_PLAN Plan
+)
+{
 	NTSTATUS Status = STATUS_SUCCESS;
+	ULONG First = 0;
+	ULONG Last = 0;
+
+	for (First = 0; First < AW8624_REGISTER_COUNT; First = Last + 1)
+	{
+		Last = First;
 
-	AW8624ReadRegWithCheck(pDevice, Address, &RegData, sizeof(RegData));
-	RegData &= Mask;
-	RegData |= Value;
-	AW8624WriteRegWithCheck(pDevice, Address, RegData);
+		if (!Plan->Present[First])
+		{
+			continue;
+		}
+
+		while (Last + 1 < AW8624_REGISTER_COUNT && Plan->Present[Last + 1])
+		{
+			Last++;
+		}
+
+		Plan->Registers += Last - First + 1;
+
+		Status = AW8624PlanWriteRun(pDevice, Plan, (UCHAR)First, Last - First + 1);
+		if (!NT_SUCCESS(Status))
+		{
+			return Status;
+		}
+	}
 
 	return Status;
 }
@@ -127,10 +681,13 @@ AW8624Standby(
 )
 {
 	NTSTATUS Status = STATUS_SUCCESS;
+	AW8624_REG_TRANSACTION Transaction;
 
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_SYSINTM, AW8624_BIT_SYSINTM_UVLO_MASK, AW8624_BIT_SYSINTM_UVLO_OFF);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_SYSCTRL, AW8624_BIT_SYSCTRL_WORK_MODE_MASK, AW8624_BIT_SYSCTRL_STANDBY);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_DBGCTRL, AW8624_BIT_DBGCTRL_INTN_TRG_SEL_MASK, AW8624_BIT_DBGCTRL_TRG_SEL_ENABLE);
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSINTM, AW8624_BIT_SYSINTM_UVLO_MASK, AW8624_BIT_SYSINTM_UVLO_OFF);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSCTRL, AW8624_BIT_SYSCTRL_WORK_MODE_MASK, AW8624_BIT_SYSCTRL_STANDBY);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_DBGCTRL, AW8624_BIT_DBGCTRL_INTN_TRG_SEL_MASK, AW8624_BIT_DBGCTRL_TRG_SEL_ENABLE);
+	Status = AW8624TransactionCommit(pDevice, &Transaction);
 
 #ifdef DEBUG
 	if (!NT_SUCCESS(Status))
@@ -147,14 +704,21 @@ AW8624Standby(
 }
 
 NTSTATUS
-AW8624Activate(
-	PDEVICE_CONTEXT pDevice
+AW8624CommitAndActivate(
+	PDEVICE_CONTEXT pDevice,
+	PAW8624_REG_TRANSACTION Transaction
 )
 {
 	NTSTATUS Status = STATUS_SUCCESS;
-	UINT16 RegData = 0;
+	UINT8 RegData = 0;
+
+	// Wake-up is merged with any SYSCTRL bits already pending in the transaction
+	AW8624TransactionSetBits(Transaction, AW8624_REG_SYSCTRL, AW8624_BIT_SYSCTRL_WORK_MODE_MASK, AW8624_BIT_SYSCTRL_ACTIVE);
+
+	// Route the shared pin to INTN while active, standby hands it back to TRIG
+	AW8624TransactionSetBits(Transaction, AW8624_REG_DBGCTRL, AW8624_BIT_DBGCTRL_INTN_TRG_SEL_MASK, AW8624_BIT_DBGCTRL_INTN_SEL_ENABLE);
+	AW8624CommitWithCheck(pDevice, Transaction);
 
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_SYSCTRL, AW8624_BIT_SYSCTRL_WORK_MODE_MASK, AW8624_BIT_SYSCTRL_ACTIVE);
 	AW8624ReadRegWithCheck(pDevice, AW8624_REG_SYSINT, &RegData, sizeof(RegData));
 	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_SYSINTM, AW8624_BIT_SYSINTM_UVLO_MASK, AW8624_BIT_SYSINTM_UVLO_EN);
 
@@ -172,6 +736,32 @@ AW8624Activate(
 	return Status;
 }
 
+NTSTATUS
+AW8624Activate(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	AW8624_REG_TRANSACTION Transaction;
+
+	AW8624TransactionBegin(&Transaction);
+
+	return AW8624CommitAndActivate(pDevice, &Transaction);
+}
+
+NTSTATUS
+AW8624ActivateWithPlayMode(
+	PDEVICE_CONTEXT pDevice,
+	UINT8 PlayMode
+)
+{
+	AW8624_REG_TRANSACTION Transaction;
+
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSCTRL, AW8624_BIT_SYSCTRL_PLAY_MODE_MASK, PlayMode);
+
+	return AW8624CommitAndActivate(pDevice, &Transaction);
+}
+
 NTSTATUS
 AW8624RamMode(
 	PDEVICE_CONTEXT pDevice
@@ -179,9 +769,7 @@ AW8624RamMode(
 {
 	NTSTATUS Status = STATUS_SUCCESS;
 
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_SYSCTRL, AW8624_BIT_SYSCTRL_PLAY_MODE_MASK, AW8624_BIT_SYSCTRL_PLAY_MODE_RAM);
-
-	Status = AW8624Activate(pDevice);
+	Status = AW8624ActivateWithPlayMode(pDevice, AW8624_BIT_SYSCTRL_PLAY_MODE_RAM);
 
 #ifdef DEBUG
 	if (!NT_SUCCESS(Status))
@@ -198,15 +786,53 @@ AW8624RamMode(
 }
 
 NTSTATUS
-AW8624Stop(
+AW8624Go(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+
+	KeClearEvent(&pDevice->PlaybackDoneEvent);
+	InterlockedExchange(&pDevice->PlaybackActive, TRUE);
+
+	Status = AW8624SpbWrite(pDevice, AW8624_REG_GO, AW8624_BIT_GO_ENABLE);
+	if (!NT_SUCCESS(Status))
+	{
+		InterlockedExchange(&pDevice->PlaybackActive, FALSE);
+	}
+
+	return Status;
+}
+
+NTSTATUS
+AW8624WaitForPlaybackDone(
 	PDEVICE_CONTEXT pDevice
 )
 {
 	NTSTATUS Status = STATUS_SUCCESS;
-	UINT16 RegData = 0;
-	UINT8 Count = 100;
+	LARGE_INTEGER Timeout;
+	UINT8 RegData = 0;
+	UINT8 Count = AW8624_STOP_POLL_COUNT;
+
+	Timeout.QuadPart = WDF_REL_TIMEOUT_IN_MS(AW8624_STOP_TIMEOUT_MS);
 
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_GO, AW8624_BIT_GO_MASK, AW8624_BIT_GO_DISABLE);
+	Status = KeWaitForSingleObject(
+		&pDevice->PlaybackDoneEvent,
+		Executive,
+		KernelMode,
+		FALSE,
+		&Timeout);
+
+	if (Status == STATUS_SUCCESS)
+	{
+		return Status;
+	}
+
+	//
+	// No DONE interrupt arrived in time, fall back to polling
+	//
+	pDevice->StopTimeouts++;
+	Status = STATUS_SUCCESS;
 
 	do
 	{
@@ -214,6 +840,31 @@ AW8624Stop(
 		Count--;
 	} while ((Count != 0) && ((RegData & 0x0F) != 0));
 
+	return Status;
+}
+
+NTSTATUS
+AW8624Stop(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+
+	AW8624WriteRegWithCheck(pDevice, AW8624_REG_GO, AW8624_BIT_GO_DISABLE);
+
+	//
+	// Only wait for braking to finish if something was actually playing,
+	// the DONE interrupt clears PlaybackActive once the chip goes idle
+	//
+	if (InterlockedExchange(&pDevice->PlaybackActive, FALSE))
+	{
+		Status = AW8624WaitForPlaybackDone(pDevice);
+		if (!NT_SUCCESS(Status))
+		{
+			return Status;
+		}
+	}
+
 	Status = AW8624Standby(pDevice);
 #ifdef DEBUG
 	if (!NT_SUCCESS(Status))
@@ -236,8 +887,12 @@ AW8624Start(
 	NTSTATUS Status = STATUS_SUCCESS;
 
 	Status = AW8624Activate(pDevice);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
 
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_GO, AW8624_BIT_GO_MASK, AW8624_BIT_GO_ENABLE);
+	Status = AW8624Go(pDevice);
 
 #ifdef DEBUG
 	if (!NT_SUCCESS(Status))
@@ -253,127 +908,1560 @@ AW8624Start(
 	return Status;
 }
 
-NTSTATUS
+//
+// F_PRE and F_LRA_F0 hold the drive period as 1e9 / (f0 * vib_f0_coeff),
+// with f0 in 0.1 Hz. The conversion is its own inverse.
+//
+UINT16
+AW8624F0Period(
+	PDEVICE_CONTEXT pDevice,
+	ULONG F0
+)
+{
+	ULONGLONG Period = 1000000000ULL / ((ULONGLONG)F0 * pDevice->Profile.F0Coeff);
+
+	// Saturated, so a measured period far outside the f0 range can not wrap back into it
+	return (UINT16)min(Period, 0xFFFF);
+}
+
+//
+// A coefficient is usable when every f0 in range maps to a
+// period the 16-bit F_PRE and F_LRA_F0 registers can hold
+//
+BOOLEAN
+AW8624F0CoeffValid(
+	ULONG F0Coeff
+)
+{
+	if (F0Coeff == 0)
+	{
+		return FALSE;
+	}
+
+	return 1000000000ULL / ((ULONGLONG)AW8624_F0_MAX * F0Coeff) >= 1 &&
+		1000000000ULL / ((ULONGLONG)AW8624_F0_MIN * F0Coeff) <= 0xFFFF;
+}
+
+VOID
+AW8624SetF0(
+	PDEVICE_CONTEXT pDevice,
+	ULONG F0
+)
+{
+	UINT16 Period = AW8624F0Period(pDevice, F0);
+
+	pDevice->F0 = F0;
+	pDevice->ProfileImage.Timing[0] = (UCHAR)(Period >> 8);
+	pDevice->ProfileImage.Timing[1] = (UCHAR)(Period & 0xFF);
+
+	// F_PRE in the chip is stale until continuous mode is prepared again
+	pDevice->ContinuousModePrepared = FALSE;
+}
+
+VOID
+AW8624BuildProfileImage(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	PAW8624_PROFILE Profile = &pDevice->Profile;
+	PAW8624_PROFILE_IMAGE Image = &pDevice->ProfileImage;
+
+	// F_PRE starts from the preset until calibration calls AW8624SetF0
+	Image->Timing[0] = (UCHAR)(AW8624F0Period(pDevice, Profile->F0Preset) >> 8);
+	Image->Timing[1] = (UCHAR)(AW8624F0Period(pDevice, Profile->F0Preset) & 0xFF);
+	Image->Timing[2] = (UCHAR)(Profile->ContTd >> 8);
+	Image->Timing[3] = (UCHAR)(Profile->ContTd & 0xFF);
+	Image->Timing[4] = Profile->Tset;
+
+	Image->Bemf[0] = (UCHAR)(Profile->ContZcThr >> 8);
+	Image->Bemf[1] = (UCHAR)(Profile->ContZcThr & 0xFF);
+	RtlCopyMemory(&Image->Bemf[2], Profile->BemfConfig, sizeof(Profile->BemfConfig));
+
+	Image->Drive[0] = AW8624_TIME_NZC;
+	Image->Drive[1] = Profile->ContDrvLvl;
+	Image->Drive[2] = Profile->ContDrvLvlOv;
+}
+
+NTSTATUS
+AW8624PrepareContinuousMode(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	AW8624_REG_TRANSACTION Transaction;
+
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_DATCTRL, AW8624_BIT_DATCTRL_FC_MASK, AW8624_BIT_DATCTRL_FC_1000HZ);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_DATCTRL, AW8624_BIT_DATCTRL_LPF_ENABLE_MASK, AW8624_BIT_DATCTRL_LPF_ENABLE);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_ZC_DETEC_MASK, AW8624_BIT_CONT_CTRL_ZC_DETEC_ENABLE);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_WAIT_PERIOD_MASK, AW8624_BIT_CONT_CTRL_WAIT_1PERIOD);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_MODE_MASK, AW8624_BIT_CONT_CTRL_BY_GO_SIGNAL);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_EN_CLOSE_MASK, AW8624_BIT_CONT_CTRL_CLOSE_PLAYBACK);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_F0_DETECT_MASK, AW8624_BIT_CONT_CTRL_F0_DETECT_DISABLE);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_O2C_MASK, AW8624_BIT_CONT_CTRL_O2C_DISABLE);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_AUTO_BRK_MASK, AW8624_BIT_CONT_CTRL_AUTO_BRK_ENABLE);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_BEMF_NUM, AW8624_BIT_BEMF_NUM_BRK_MASK, pDevice->Profile.ContNumBrk);
+	AW8624CommitWithCheck(pDevice, &Transaction);
+
+	AW8624WriteBurstWithCheck(pDevice, AW8624_REG_F_PRE_H, pDevice->ProfileImage.Timing, sizeof(pDevice->ProfileImage.Timing));
+	AW8624WriteBurstWithCheck(pDevice, AW8624_REG_ZC_THRSH_H, pDevice->ProfileImage.Bemf, sizeof(pDevice->ProfileImage.Bemf));
+	AW8624WriteBurstWithCheck(pDevice, AW8624_REG_TIME_NZC, pDevice->ProfileImage.Drive, sizeof(pDevice->ProfileImage.Drive));
+
+	pDevice->ContinuousModePrepared = TRUE;
+
+	return Status;
+}
+
+VOID
+AW8624BuildDriveLevels(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	ULONG i = 0;
+
+	for (i = 0; i < AW8624_INTENSITY_LEVELS; i++)
+	{
+		pDevice->DriveLevels[i].DrvLvl = (UINT8)((pDevice->Profile.ContDrvLvl * i + 50) / 100);
+		pDevice->DriveLevels[i].DrvLvlOv = (UINT8)((pDevice->Profile.ContDrvLvlOv * i + 50) / 100);
+		pDevice->DriveLevels[i].RamGain = (UINT8)((AW8624_RAM_GAIN_MAX * i + 50) / 100);
+	}
+
+	// An intensity of 0 means the caller did not ask for one
+	pDevice->DriveLevels[0] = pDevice->DriveLevels[AW8624_INTENSITY_LEVELS - 1];
+}
+
+NTSTATUS
+AW8624SetIntensity(
+	PDEVICE_CONTEXT pDevice,
+	ULONG Intensity
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	PAW8624_DRIVE_LEVEL DriveLevel = NULL;
+
+	if (Intensity >= AW8624_INTENSITY_LEVELS)
+	{
+		Intensity = AW8624_INTENSITY_LEVELS - 1;
+	}
+
+	DriveLevel = &pDevice->DriveLevels[Intensity];
+
+	// Only registers whose cached value differs are written
+	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_DRV_LVL, 0x00, DriveLevel->DrvLvl);
+	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_DRV_LVL_OV, 0x00, DriveLevel->DrvLvlOv);
+
+	return Status;
+}
+
+NTSTATUS
+AW8624SetRamGain(
+	PDEVICE_CONTEXT pDevice,
+	ULONG Intensity
+)
+{
+	if (Intensity >= AW8624_INTENSITY_LEVELS)
+	{
+		Intensity = AW8624_INTENSITY_LEVELS - 1;
+	}
+
+	// RAM playback ignores DRV_LVL, its amplitude is the DATDBG gain
+	return AW8624WriteBits(pDevice, AW8624_REG_DATDBG, 0x00, pDevice->DriveLevels[Intensity].RamGain);
+}
+
+NTSTATUS
 AW8624VibrateUntilStopped(
+	PDEVICE_CONTEXT pDevice,
+	ULONG Intensity
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+#ifdef DEBUG
+	ULONG TransferCount = pDevice->I2CContext.TransferCount;
+#endif
+
+	//
+	// The continuous mode parameters only change on reset or UVLO,
+	// so normally all that is left to do here is select the mode and GO
+	//
+	if (!pDevice->ContinuousModePrepared)
+	{
+		Status = AW8624PrepareContinuousMode(pDevice);
+		if (!NT_SUCCESS(Status))
+		{
+			return Status;
+		}
+	}
+
+	Status = AW8624SetIntensity(pDevice, Intensity);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+	// Already vibrating, so an intensity change is all that was asked for
+	if (pDevice->PlaybackActive)
+	{
+		return Status;
+	}
+
+	Status = AW8624ActivateWithPlayMode(pDevice, AW8624_BIT_SYSCTRL_PLAY_MODE_CONT);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+	pDevice->RamPlayback = FALSE;
+
+	Status = AW8624Go(pDevice);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+#ifdef DEBUG
+	Trace(
+		TRACE_LEVEL_INFORMATION,
+		TRACE_SPB,
+		"%!FUNC!: %lu bus transfers",
+		pDevice->I2CContext.TransferCount - TransferCount);
+#endif
+
+	return Status;
+}
+
+VOID
+AW8624BlinkCancel(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	//
+	// The timer callback only queues the work item, so waiting for it
+	// is safe with ControllerLock held. Once it has returned no edge of
+	// the old pattern can be stamped with the new generation.
+	//
+	if (InterlockedExchange(&pDevice->Blink.Active, FALSE))
+	{
+		WdfTimerStop(pDevice->Blink.Timer, TRUE);
+	}
+
+	InterlockedIncrement(&pDevice->Blink.Generation);
+}
+
+NTSTATUS
+AW8624Blink(
+	PDEVICE_CONTEXT pDevice,
+	ULONG HwNId,
+	ULONG PeriodMs,
+	ULONG DutyCycle,
+	ULONG CycleCount,
+	ULONG Intensity
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	PAW8624_BLINK Blink = &pDevice->Blink;
+	ULONG OnTimeMs = (ULONG)(((ULONGLONG)PeriodMs * min(DutyCycle, 100)) / 100);
+
+	AW8624BlinkCancel(pDevice);
+
+	// Degenerate patterns are plain on or off
+	if (OnTimeMs == 0)
+	{
+		return AW8624Stop(pDevice);
+	}
+
+	if (OnTimeMs == PeriodMs)
+	{
+		return AW8624Vibrate(pDevice, Intensity);
+	}
+
+	Blink->HwNId = HwNId;
+	Blink->OnTimeMs = OnTimeMs;
+	Blink->OffTimeMs = PeriodMs - OnTimeMs;
+	Blink->CyclesLeft = CycleCount;
+
+	//
+	// The first rising edge programs the playback mode and the drive
+	// level, every later edge is a single write to GO
+	//
+	Status = AW8624Vibrate(pDevice, Intensity);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+	Blink->On = TRUE;
+	Blink->Edges++;
+
+	InterlockedExchange(&Blink->Active, TRUE);
+	WdfTimerStart(Blink->Timer, WDF_REL_TIMEOUT_IN_MS(Blink->OnTimeMs));
+
+	return Status;
+}
+
+VOID
+AW8624BlinkTimer(
+	WDFTIMER Timer
+)
+{
+	PDEVICE_CONTEXT pDevice = DeviceGetContext(WdfTimerGetParentObject(Timer));
+
+	// The bus can not be touched at DISPATCH_LEVEL
+	InterlockedExchange(&pDevice->Blink.QueuedGeneration, pDevice->Blink.Generation);
+	WdfWorkItemEnqueue(pDevice->Blink.WorkItem);
+}
+
+VOID
+AW8624BlinkWorkItem(
+	WDFWORKITEM WorkItem
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	PDEVICE_CONTEXT pDevice = DeviceGetContext(WdfWorkItemGetParentObject(WorkItem));
+	PAW8624_BLINK Blink = &pDevice->Blink;
+	PAW8624_REQUEST_QUEUE Queue = &pDevice->RequestQueue;
+	ULONG NextEdgeMs = 0;
+
+	WdfWaitLockAcquire(pDevice->ControllerLock, NULL);
+
+	// Each stamp is consumed once, a second run for the same edge finds 0
+	if (!Blink->Active ||
+		InterlockedExchange(&Blink->QueuedGeneration, 0) != Blink->Generation)
+	{
+		goto exit;
+	}
+
+	if (Blink->On)
+	{
+		// HWN_CYCLE_COUNT of 0 blinks until the next request
+		if (Blink->CyclesLeft != 0 && --Blink->CyclesLeft == 0)
+		{
+			InterlockedExchange(&Blink->Active, FALSE);
+
+			Status = AW8624Stop(pDevice);
+			pDevice->PreviousState = HWN_OFF;
+
+			//
+			// Report the HwN as off once the pattern has run out, unless
+			// a newer request for it is still waiting. The request worker
+			// holds ControllerLock while it drains, so such a request is
+			// always seen pending here.
+			//
+			WdfWaitLockAcquire(Queue->Lock, NULL);
+
+			if (pDevice->CurrentStates != NULL &&
+				!Queue->Requests[Blink->HwNId].Pending &&
+				pDevice->CurrentStates[Blink->HwNId].OffOnBlink == HWN_BLINK)
+			{
+				pDevice->CurrentStates[Blink->HwNId].OffOnBlink = HWN_OFF;
+			}
+
+			WdfWaitLockRelease(Queue->Lock);
+			goto exit;
+		}
+
+		// Not playing from here on, so a following HWN_ON issues GO again
+		InterlockedExchange(&pDevice->PlaybackActive, FALSE);
+		InterlockedExchange(&Blink->OffEdgeDonePending, TRUE);
+
+		Status = AW8624SpbWrite(pDevice, AW8624_REG_GO, AW8624_BIT_GO_DISABLE);
+		if (!NT_SUCCESS(Status))
+		{
+			InterlockedExchange(&Blink->OffEdgeDonePending, FALSE);
+		}
+
+		NextEdgeMs = Blink->OffTimeMs;
+	}
+	else
+	{
+		Status = AW8624Go(pDevice);
+		NextEdgeMs = Blink->OnTimeMs;
+	}
+
+	if (!NT_SUCCESS(Status))
+	{
+		InterlockedExchange(&Blink->Active, FALSE);
+		goto exit;
+	}
+
+	Blink->On = !Blink->On;
+	Blink->Edges++;
+
+	WdfTimerStart(Blink->Timer, WDF_REL_TIMEOUT_IN_MS(NextEdgeMs));
+
+exit:
+	WdfWaitLockRelease(pDevice->ControllerLock);
+
+#ifdef DEBUG
+	if (!NT_SUCCESS(Status))
+	{
+		Trace(
+			TRACE_LEVEL_ERROR,
+			TRACE_HAPTICS,
+			"%!FUNC!: Error toggling blink edge - 0x%08lX",
+			Status);
+	}
+#endif
+}
+
+//
+// Fixed part of the bring-up, applied through a register plan on top of
+// the profile values. Leaves the chip in standby with RAM playback
+// selected and GO clear.
+//
+static const AW8624_REG_UPDATE AW8624InitSequence[] =
+{
+	{ AW8624_REG_SYSINTM, AW8624_BIT_SYSINTM_UVLO_MASK, AW8624_BIT_SYSINTM_UVLO_OFF },
+	{ AW8624_REG_SYSCTRL, AW8624_BIT_SYSCTRL_WORK_MODE_MASK, AW8624_BIT_SYSCTRL_STANDBY },
+	{ AW8624_REG_SYSCTRL, AW8624_BIT_SYSCTRL_PLAY_MODE_MASK, AW8624_BIT_SYSCTRL_PLAY_MODE_RAM },
+	{ AW8624_REG_GO, 0x00, AW8624_BIT_GO_DISABLE },
+	{ AW8624_REG_DBGCTRL, AW8624_BIT_DBGCTRL_INTN_TRG_SEL_MASK, AW8624_BIT_DBGCTRL_TRG_SEL_ENABLE },
+	{ AW8624_REG_PWMPRC, AW8624_BIT_PWMPRC_PRC_EN_MASK, AW8624_BIT_PWMPRC_PRC_DISABLE },
+	{ AW8624_REG_PWMDBG, AW8624_BIT_PWMDBG_PWM_MODE_MASK, AW8624_BIT_PWMDBG_PWM_24K },
+	{ AW8624_REG_WAVECTRL, AW8624_BIT_WAVECTRL_NUM_OV_DRIVER_MASK, AW8624_BIT_WAVECTRL_NUM_OV_DRIVER },
+	{ AW8624_REG_PRLVL, AW8624_BIT_PRLVL_PR_EN_MASK, AW8624_BIT_PRLVL_PR_DISABLE },
+	{ AW8624_REG_THRS_BRA_END, 0x00, 0x00 },
+	{ AW8624_REG_R_SPARE, AW8624_BIT_R_SPARE_MASK, AW8624_BIT_R_SPARE_ENABLE },
+	{ AW8624_REG_DETCTRL, AW8624_BIT_DETCTRL_PROTECT_MASK, AW8624_BIT_DETCTRL_PROTECT_NO_ACTION },
+	{ AW8624_REG_ADCTEST, AW8624_BIT_DETCTRL_VBAT_MODE_MASK, AW8624_BIT_DETCTRL_VBAT_HW_COMP },
+};
+
+NTSTATUS
+AW8624HapticsInit(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	AW8624_REG_PLAN Plan;
+	ULONG i = 0;
+
+#ifdef DEBUG
+	Trace(TRACE_LEVEL_INFORMATION, TRACE_SPB, "%!FUNC!: Entry");
+#endif
+
+	AW8624PlanBegin(&Plan);
+
+	for (i = 0; i < ARRAYSIZE(AW8624InitSequence); i++)
+	{
+		AW8624PlanSetBits(&Plan, AW8624InitSequence[i].Address, AW8624InitSequence[i].Mask, AW8624InitSequence[i].Value);
+	}
+
+	AW8624PlanSetBits(&Plan, AW8624_REG_TRIM_LRA, 0x00, pDevice->TrimLra);
+	AW8624PlanSetBits(&Plan, AW8624_REG_SW_BRAKE, 0x00, pDevice->Profile.SwBrake);
+	AW8624PlanSetBits(&Plan, AW8624_REG_TSET, 0x00, pDevice->Profile.Tset);
+
+	// ZC_THRSH, then vib_bemf_config into BEMF_VTHH_H through BEMF_VTHL_L
+	for (i = 0; i < sizeof(pDevice->ProfileImage.Bemf); i++)
+	{
+		AW8624PlanSetBits(&Plan, (UCHAR)(AW8624_REG_ZC_THRSH_H + i), 0x00, pDevice->ProfileImage.Bemf[i]);
+	}
+
+	Status = AW8624PlanCommit(pDevice, &Plan);
+
+	// The soft reset ended any playback
+	InterlockedExchange(&pDevice->PlaybackActive, FALSE);
+
+#ifdef DEBUG
+	Trace(
+		TRACE_LEVEL_INFORMATION,
+		TRACE_SPB,
+		"%!FUNC!: %lu registers in %lu bursts - 0x%08lX",
+		Plan.Registers,
+		Plan.Bursts,
+		Status);
+#endif
+
+	return Status;
+}
+
+NTSTATUS
+AW8624DetectF0(
+	PDEVICE_CONTEXT pDevice,
+	PULONG F0
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	AW8624_REG_TRANSACTION Transaction;
+	LARGE_INTEGER Interval;
+	UCHAR Period[2] = { 0 };
+	UINT8 RegData = 0;
+	ULONG Count = 0;
+
+	//
+	// The chip drives the LRA open loop from F_PRE, then lets it ring
+	// down and measures the back-EMF period into F_LRA_F0
+	//
+	AW8624WriteReg16WithCheck(pDevice, AW8624_REG16_F_PRE, AW8624F0Period(pDevice, pDevice->Profile.F0Preset));
+
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_DATCTRL, AW8624_BIT_DATCTRL_FC_MASK, AW8624_BIT_DATCTRL_FC_1000HZ);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_DATCTRL, AW8624_BIT_DATCTRL_LPF_ENABLE_MASK, AW8624_BIT_DATCTRL_LPF_ENABLE);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_EN_CLOSE_MASK, AW8624_BIT_CONT_CTRL_OPEN_PLAYBACK);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_F0_DETECT_MASK, AW8624_BIT_CONT_CTRL_F0_DETECT_ENABLE);
+	AW8624CommitWithCheck(pDevice, &Transaction);
+
+	AW8624WriteRegWithCheck(pDevice, AW8624_REG_DRV_LVL, pDevice->Profile.ContDrvLvl);
+
+	// Detection clobbers the continuous mode setup
+	pDevice->ContinuousModePrepared = FALSE;
+
+	Status = AW8624ActivateWithPlayMode(pDevice, AW8624_BIT_SYSCTRL_PLAY_MODE_CONT);
+	if (NT_SUCCESS(Status))
+	{
+		Status = AW8624Go(pDevice);
+	}
+
+	//
+	// Interrupts may not be connected yet, so the end of the
+	// measurement is polled rather than waited on
+	//
+	Interval.QuadPart = WDF_REL_TIMEOUT_IN_MS(AW8624_F0_DETECT_POLL_MS);
+
+	for (Count = 0; NT_SUCCESS(Status) && Count < AW8624_F0_DETECT_POLL_COUNT; Count++)
+	{
+		KeDelayExecutionThread(KernelMode, FALSE, &Interval);
+
+		Status = AW8624SpbRead(pDevice, AW8624_REG_GLB_STATE, &RegData, sizeof(RegData));
+		if (NT_SUCCESS(Status) && (RegData & 0x0F) == 0)
+		{
+			break;
+		}
+	}
+
+	InterlockedExchange(&pDevice->PlaybackActive, FALSE);
+
+	if (NT_SUCCESS(Status) && Count == AW8624_F0_DETECT_POLL_COUNT)
+	{
+		AW8624SpbWrite(pDevice, AW8624_REG_GO, AW8624_BIT_GO_DISABLE);
+		Status = STATUS_IO_TIMEOUT;
+	}
+
+	if (NT_SUCCESS(Status))
+	{
+		Status = AW8624SpbRead(pDevice, AW8624_REG16_F_LRA_F0, Period, sizeof(Period));
+	}
+
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_EN_CLOSE_MASK, AW8624_BIT_CONT_CTRL_CLOSE_PLAYBACK);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_F0_DETECT_MASK, AW8624_BIT_CONT_CTRL_F0_DETECT_DISABLE);
+	AW8624TransactionCommit(pDevice, &Transaction);
+
+	AW8624Standby(pDevice);
+
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+	if (Period[0] == 0 && Period[1] == 0)
+	{
+		return STATUS_DEVICE_DATA_ERROR;
+	}
+
+	*F0 = AW8624F0Period(pDevice, (Period[0] << 8) | Period[1]);
+
+	if (*F0 < AW8624_F0_MIN || *F0 > AW8624_F0_MAX)
+	{
+		return STATUS_DEVICE_DATA_ERROR;
+	}
+
+	return Status;
+}
+
+LONG
+AW8624RoundDiv(
+	LONG Numerator,
+	LONG Denominator
+)
+{
+	if ((Numerator < 0) != (Denominator < 0))
+	{
+		return (Numerator - Denominator / 2) / Denominator;
+	}
+
+	return (Numerator + Denominator / 2) / Denominator;
+}
+
+LONG
+AW8624ClampTrim(
+	LONG Code
+)
+{
+	return max(AW8624_TRIM_LRA_MIN, min(AW8624_TRIM_LRA_MAX, Code));
+}
+
+NTSTATUS
+AW8624MeasureF0AtTrim(
+	PDEVICE_CONTEXT pDevice,
+	LONG Code,
+	PLONG Error
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	ULONG F0 = 0;
+
+	AW8624WriteRegWithCheck(pDevice, AW8624_REG_TRIM_LRA, (UINT8)(Code & AW8624_TRIM_LRA_CODE_MASK));
+
+	Status = AW8624DetectF0(pDevice, &F0);
+	if (NT_SUCCESS(Status))
+	{
+		*Error = (LONG)F0 - (LONG)pDevice->Profile.F0Preset;
+	}
+
+	return Status;
+}
+
+NTSTATUS
+AW8624SearchTrim(
+	PDEVICE_CONTEXT pDevice,
+	PLONG Trim
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	LONG Preset = (LONG)pDevice->Profile.F0Preset;
+	LONG Tolerance = Preset / (2 * AW8624_TRIM_LRA_STEPS_PER_UNIT);
+	LONG PrevCode = 0;
+	LONG PrevError = 0;
+	LONG Code = 0;
+	LONG Error = 0;
+	LONG NextCode = 0;
+	LONG BestCode = 0;
+	LONG BestError = 0;
+	ULONG Measurements = 1;
+
+	//
+	// Untrimmed measurement first, the vendor's linear model gives the
+	// second probe and secant steps refine it from there. A handful of
+	// drive cycles replaces a sweep of the whole code space.
+	//
+	Status = AW8624MeasureF0AtTrim(pDevice, 0, &PrevError);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+	BestError = PrevError;
+
+	Code = AW8624ClampTrim(AW8624RoundDiv(
+		AW8624_TRIM_LRA_STEPS_PER_UNIT * PrevError,
+		Preset + PrevError));
+
+	while (abs(BestError) > Tolerance &&
+		Code != PrevCode &&
+		Measurements < AW8624_TRIM_MAX_MEASUREMENTS)
+	{
+		Status = AW8624MeasureF0AtTrim(pDevice, Code, &Error);
+		if (!NT_SUCCESS(Status))
+		{
+			break;
+		}
+
+		Measurements++;
+
+		if (abs(Error) < abs(BestError))
+		{
+			BestCode = Code;
+			BestError = Error;
+		}
+
+		if (Error == PrevError)
+		{
+			break;
+		}
+
+		NextCode = AW8624ClampTrim(Code - AW8624RoundDiv(Error * (Code - PrevCode), Error - PrevError));
+
+		PrevCode = Code;
+		PrevError = Error;
+		Code = NextCode;
+	}
+
+#ifdef DEBUG
+	Trace(
+		TRACE_LEVEL_INFORMATION,
+		TRACE_SPB,
+		"%!FUNC!: TRIM_LRA %ld after %lu measurements, residual %ld (0.1 Hz)",
+		BestCode,
+		Measurements,
+		BestError);
+#endif
+
+	// The best probe stands even if a later one failed
+	*Trim = BestCode;
+
+	return STATUS_SUCCESS;
+}
+
+NTSTATUS
+AW8624Calibrate(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	WDFKEY Key = NULL;
+	ULONG F0 = 0;
+	ULONG TrimLra = 0;
+	LONG Trim = 0;
+	DECLARE_CONST_UNICODE_STRING(F0ValueName, AW8624_F0_VALUE_NAME);
+	DECLARE_CONST_UNICODE_STRING(TrimLraValueName, AW8624_TRIM_LRA_VALUE_NAME);
+
+	//
+	// A unit is measured once, later starts reuse the stored result.
+	// A failed measurement keeps the DTS preset and is retried by the setup
+	// work item the next time the chip is initialized.
+	//
+	if (pDevice->Calibrated)
+	{
+		return Status;
+	}
+
+	AW8624SetF0(pDevice, pDevice->Profile.F0Preset);
+	pDevice->TrimLra = 0;
+
+	Status = WdfDeviceOpenRegistryKey(
+		pDevice->Device,
+		PLUGPLAY_REGKEY_DEVICE,
+		KEY_READ | KEY_WRITE,
+		WDF_NO_OBJECT_ATTRIBUTES,
+		&Key);
+
+	if (NT_SUCCESS(Status) &&
+		NT_SUCCESS(WdfRegistryQueryULong(Key, (PUNICODE_STRING)&F0ValueName, &F0)) &&
+		NT_SUCCESS(WdfRegistryQueryULong(Key, (PUNICODE_STRING)&TrimLraValueName, &TrimLra)) &&
+		F0 >= AW8624_F0_MIN && F0 <= AW8624_F0_MAX &&
+		TrimLra <= AW8624_TRIM_LRA_CODE_MASK)
+	{
+		AW8624SetF0(pDevice, F0);
+		pDevice->TrimLra = (UINT8)TrimLra;
+		pDevice->Calibrated = TRUE;
+		WdfRegistryClose(Key);
+
+		return AW8624SpbWrite(pDevice, AW8624_REG_TRIM_LRA, pDevice->TrimLra);
+	}
+
+	Status = AW8624SearchTrim(pDevice, &Trim);
+
+	// f0 is measured again with the chosen trim, F_PRE is derived from it
+	if (NT_SUCCESS(Status))
+	{
+		Status = AW8624SpbWrite(pDevice, AW8624_REG_TRIM_LRA, (UINT8)(Trim & AW8624_TRIM_LRA_CODE_MASK));
+	}
+
+	if (NT_SUCCESS(Status))
+	{
+		Status = AW8624DetectF0(pDevice, &F0);
+	}
+
+	if (NT_SUCCESS(Status))
+	{
+		AW8624SetF0(pDevice, F0);
+		pDevice->TrimLra = (UINT8)(Trim & AW8624_TRIM_LRA_CODE_MASK);
+		pDevice->Calibrated = TRUE;
+
+		if (Key != NULL)
+		{
+			WdfRegistryAssignULong(Key, (PUNICODE_STRING)&F0ValueName, pDevice->F0);
+			WdfRegistryAssignULong(Key, (PUNICODE_STRING)&TrimLraValueName, pDevice->TrimLra);
+		}
+	}
+
+#ifdef DEBUG
+	Trace(
+		TRACE_LEVEL_INFORMATION,
+		TRACE_SPB,
+		"%!FUNC!: F0 = %lu (0.1 Hz), TRIM_LRA = 0x%02X, calibration status 0x%08lX",
+		pDevice->F0,
+		pDevice->TrimLra,
+		Status);
+#endif
+
+	if (Key != NULL)
+	{
+		WdfRegistryClose(Key);
+	}
+
+	return AW8624SpbWrite(pDevice, AW8624_REG_TRIM_LRA, pDevice->TrimLra);
+}
+
+VOID
+AW8624LoadProfile(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	WDFKEY Key = NULL;
+	AW8624_PROFILE Profile;
+	ULONG ValueLength = 0;
+	ULONG ValueType = 0;
+	DECLARE_CONST_UNICODE_STRING(ProfileValueName, AW8624_PROFILE_VALUE_NAME);
+
+	pDevice->Profile = AW8624DefaultProfile;
+
+	Status = WdfDeviceOpenRegistryKey(
+		pDevice->Device,
+		PLUGPLAY_REGKEY_DEVICE,
+		KEY_READ,
+		WDF_NO_OBJECT_ATTRIBUTES,
+		&Key);
+
+	if (NT_SUCCESS(Status))
+	{
+		Status = WdfRegistryQueryValue(
+			Key,
+			(PUNICODE_STRING)&ProfileValueName,
+			sizeof(Profile),
+			&Profile,
+			&ValueLength,
+			&ValueType);
+
+		WdfRegistryClose(Key);
+	}
+
+	if (NT_SUCCESS(Status))
+	{
+		if (ValueType == REG_BINARY &&
+			ValueLength == sizeof(Profile) &&
+			Profile.Signature == AW8624_PROFILE_SIGNATURE &&
+			Profile.Version == AW8624_PROFILE_VERSION &&
+			Profile.F0Preset >= AW8624_F0_MIN &&
+			Profile.F0Preset <= AW8624_F0_MAX &&
+			AW8624F0CoeffValid(Profile.F0Coeff) &&
+			Profile.ContNumBrk <= AW8624_CONT_NUM_BRK_MAX)
+		{
+			pDevice->Profile = Profile;
+		}
+#ifdef DEBUG
+		else
+		{
+			Trace(
+				TRACE_LEVEL_WARNING,
+				TRACE_SPB,
+				"%!FUNC!: Ignoring malformed profile (type %lu, %lu bytes)",
+				ValueType,
+				ValueLength);
+		}
+#endif
+	}
+
+	AW8624BuildProfileImage(pDevice);
+}
+
+NTSTATUS
+AW8624SetupInterrupts(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	UINT8 RegData = 0;
+	AW8624_REG_TRANSACTION Transaction;
+
+#ifdef DEBUG
+	Trace(TRACE_LEVEL_INFORMATION, TRACE_SPB, "%!FUNC!: Entry");
+#endif
+
+	AW8624ReadRegWithCheck(pDevice, AW8624_REG_SYSINT, &RegData, sizeof(RegData));
+
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_DBGCTRL, AW8624_BIT_DBGCTRL_INTMODE_MASK, AW8624_BIT_DBGCTRL_INTN_EDGE_MODE);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSINTM, AW8624_BIT_SYSINTM_UVLO_MASK, AW8624_BIT_SYSINTM_UVLO_EN);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSINTM, AW8624_BIT_SYSINTM_OCD_MASK, AW8624_BIT_SYSINTM_OCD_EN);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSINTM, AW8624_BIT_SYSINTM_OT_MASK, AW8624_BIT_SYSINTM_OT_EN);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSINTM, AW8624_BIT_SYSINTM_DONE_MASK, AW8624_BIT_SYSINTM_DONE_EN);
+	Status = AW8624TransactionCommit(pDevice, &Transaction);
+
+	return Status;
+}
+
+VOID
+AW8624HandlePlaybackDone(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	InterlockedExchange(&pDevice->PlaybackActive, FALSE);
+	KeSetEvent(&pDevice->PlaybackDoneEvent, IO_NO_INCREMENT, FALSE);
+}
+
+VOID
+AW8624HandleDone(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	//
+	// The DONE of a blink off edge may arrive after the next on edge
+	// issued GO. Playback already ended with the off edge, and neither
+	// PlaybackActive nor the event may reflect it now.
+	//
+	if (InterlockedExchange(&pDevice->Blink.OffEdgeDonePending, FALSE))
+	{
+		return;
+	}
+
+	AW8624HandlePlaybackDone(pDevice);
+}
+
+VOID
+AW8624HandleUnderVoltage(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	//
+	// Playback is aborted on UVLO and the register contents can no
+	// longer be trusted, so the next request re-initializes the chip
+	//
+	InterlockedExchange(&pDevice->RecoveryPending, TRUE);
+	AW8624HandlePlaybackDone(pDevice);
+}
+
+VOID
+AW8624HandleDriverFault(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	//
+	// Over-current and over-temperature do not shut the output down
+	// (DETCTRL is set to no action), so stop driving the motor here
+	//
+	AW8624SpbWrite(pDevice, AW8624_REG_GO, AW8624_BIT_GO_DISABLE);
+	AW8624HandlePlaybackDone(pDevice);
+}
+
+//
+// SYSINT bits in the order they are serviced, faults first
+//
+static const AW8624_INTERRUPT_DISPATCH AW8624InterruptDispatch[] =
+{
+	{ AW8624_BIT_SYSINT_UVLI, AW8624HandleUnderVoltage },
+	{ AW8624_BIT_SYSINT_OCDI, AW8624HandleDriverFault },
+	{ AW8624_BIT_SYSINT_OTI, AW8624HandleDriverFault },
+	{ AW8624_BIT_SYSINT_DONEI, AW8624HandleDone },
+};
+
+VOID
+AW8624DispatchInterrupts(
+	PDEVICE_CONTEXT pDevice,
+	UINT8 SysInt
+)
+{
+	ULONG i = 0;
+
+	for (i = 0; i < AW8624_SYSINT_COUNT; i++)
+	{
+		if (SysInt & (1 << i))
+		{
+			pDevice->InterruptCounts[i]++;
+		}
+	}
+
+	for (i = 0; i < ARRAYSIZE(AW8624InterruptDispatch); i++)
+	{
+		if (SysInt & AW8624InterruptDispatch[i].Bit)
+		{
+			AW8624InterruptDispatch[i].Handler(pDevice);
+		}
+	}
+}
+
+BOOLEAN
+AW8624InterruptService(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	UINT8 RegData = 0;
+
+	// Reading SYSINT acknowledges every pending interrupt
+	Status = AW8624SpbRead(pDevice, AW8624_REG_SYSINT, &RegData, sizeof(RegData));
+	if (!NT_SUCCESS(Status))
+	{
+		return FALSE;
+	}
+
+#ifdef DEBUG
+	if (RegData & ~AW8624_BIT_SYSINT_DONEI)
+	{
+		Trace(TRACE_LEVEL_WARNING, TRACE_INTERRUPT, "%!FUNC!: SYSINT = 0x%02X", RegData);
+	}
+#endif
+
+	AW8624DispatchInterrupts(pDevice, RegData);
+
+	return RegData != 0;
+}
+
+NTSTATUS
+AW8624Recover(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+
+	if (!InterlockedExchange(&pDevice->RecoveryPending, FALSE))
+	{
+		return Status;
+	}
+
+#ifdef DEBUG
+	Trace(TRACE_LEVEL_WARNING, TRACE_INTERRUPT, "%!FUNC!: Re-initializing after UVLO");
+#endif
+
+	Status = AW8624Initialize(pDevice);
+	if (!NT_SUCCESS(Status))
+	{
+		// Try again on the next request
+		InterlockedExchange(&pDevice->RecoveryPending, TRUE);
+	}
+
+	return Status;
+}
+
+NTSTATUS
+AW8624Suspend(
 	PDEVICE_CONTEXT pDevice
 )
 {
 	NTSTATUS Status = STATUS_SUCCESS;
 
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_SYSCTRL, AW8624_BIT_SYSCTRL_PLAY_MODE_MASK, AW8624_BIT_SYSCTRL_PLAY_MODE_CONT);
-	Status = AW8624Activate(pDevice);
-	
-	// 0x754 is retrieved from the following formula: 0x3B9ACA00 / 0x802 / 0x104,
-	// where 0x802 and 0x104 are from DTS (vib_f0_pre and vib_f0_coeff respectively)
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_F_PRE_H, (0x754 >> 8) & 0xFF);
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_F_PRE_L, 0x754 & 0xFF);
+	AW8624BlinkCancel(pDevice);
+
+	Status = AW8624Stop(pDevice);
+
+	// Whatever was playing does not survive D0 exit
+	pDevice->PreviousState = HWN_OFF;
+
+	return Status;
+}
+
+NTSTATUS
+AW8624Resume(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	AW8624_REGISTER_CACHE Image;
+	AW8624_REG_PLAN Plan;
+	UCHAR Signature[AW8624_RESUME_SIGNATURE_LENGTH];
+	UINT8 RegData = 0;
+	ULONG i = 0;
+
+	//
+	// The register cache is the last known-good image of the chip,
+	// without the signature registers in it there is nothing to
+	// compare against or restore from
+	//
+	RtlCopyMemory(&Image, &pDevice->RegisterCache, sizeof(Image));
+
+	for (i = 0; i < sizeof(Signature); i++)
+	{
+		if (!Image.Valid[AW8624_RESUME_SIGNATURE + i])
+		{
+			pDevice->ColdResumes++;
+			return AW8624Initialize(pDevice);
+		}
+	}
 
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_DATCTRL, AW8624_BIT_DATCTRL_FC_MASK, AW8624_BIT_DATCTRL_FC_1000HZ);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_DATCTRL, AW8624_BIT_DATCTRL_LPF_ENABLE_MASK, AW8624_BIT_DATCTRL_LPF_ENABLE);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_ZC_DETEC_MASK, AW8624_BIT_CONT_CTRL_ZC_DETEC_ENABLE);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_WAIT_PERIOD_MASK, AW8624_BIT_CONT_CTRL_WAIT_1PERIOD);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_MODE_MASK, AW8624_BIT_CONT_CTRL_BY_GO_SIGNAL);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_EN_CLOSE_MASK, AW8624_BIT_CONT_CTRL_CLOSE_PLAYBACK);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_F0_DETECT_MASK, AW8624_BIT_CONT_CTRL_F0_DETECT_DISABLE);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_O2C_MASK, AW8624_BIT_CONT_CTRL_O2C_DISABLE);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_CONT_CTRL, AW8624_BIT_CONT_CTRL_AUTO_BRK_MASK, AW8624_BIT_CONT_CTRL_AUTO_BRK_ENABLE);
+	AW8624ReadRegWithCheck(pDevice, AW8624_RESUME_SIGNATURE, Signature, sizeof(Signature));
 
-	// from DTS (vib_cont_td)
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_TD_H, 0xF06C >> 8);
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_TD_L, 0xF06C & 0xFF);
+	if (RtlCompareMemory(Signature, &Image.Value[AW8624_RESUME_SIGNATURE], sizeof(Signature)) == sizeof(Signature))
+	{
+		pDevice->WarmResumes++;
+		return Status;
+	}
+
+	//
+	// The rail dropped, write the image back in address order.
+	// Only cached registers are written, anything the driver never
+	// touched is already at its reset value.
+	//
+	AW8624CacheInvalidate(pDevice);
 
-	// from DTS (vib_tset)
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_TSET, 0x11);
+	AW8624PlanBegin(&Plan);
 
-	// from DTS (vib_cont_zc_thr)
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_ZC_THRSH_H, 0x8F8 >> 8);
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_ZC_THRSH_L, 0x8F8 & 0xFF);
+	for (i = 0; i < AW8624_REGISTER_COUNT; i++)
+	{
+		if (Image.Valid[i])
+		{
+			AW8624PlanSetBits(&Plan, (UCHAR)i, 0x00, Image.Value[i]);
+		}
+	}
 
-	// from DTS (vib_cont_num_brk)
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_CONT_CTRL, AW8624_BIT_BEMF_NUM_BRK_MASK, 0x03);
+	Status = AW8624PlanCommit(pDevice, &Plan);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
 
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_TIME_NZC, 0x23);
+	// Flags latched while the rail came back up
+	AW8624ReadRegWithCheck(pDevice, AW8624_REG_SYSINT, &RegData, sizeof(RegData));
 
-	// from DTS (vib_cont_drv_lev)
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_DRV_LVL, 0x6B);
+	pDevice->ColdResumes++;
 
-	// from DTS (vib_cont_drv_lvl_ov)
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_DRV_LVL_OV, 0x9B);
+	// The SRAM did not survive, reload the waveform bank
+	pDevice->RamBankLoaded = FALSE;
+	if (pDevice->SetupWorkItem != NULL)
+	{
+		WdfWorkItemEnqueue(pDevice->SetupWorkItem);
+	}
 
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_GO, AW8624_BIT_GO_MASK, AW8624_BIT_GO_ENABLE);
+#ifdef DEBUG
+	Trace(
+		TRACE_LEVEL_INFORMATION,
+		TRACE_SPB,
+		"%!FUNC!: Restored %lu registers in %lu bursts",
+		Plan.Registers,
+		Plan.Bursts);
+#endif
 
 	return Status;
 }
 
+UINT16
+AW8624RamBankChecksum(
+	PUCHAR Data,
+	ULONG Length
+)
+{
+	UINT16 Checksum = 0;
+	ULONG i = 0;
+
+	for (i = 0; i < Length; i++)
+	{
+		Checksum = (UINT16)(Checksum + Data[i]);
+	}
+
+	return Checksum;
+}
+
 NTSTATUS
-AW8624HapticsInit(
-	PDEVICE_CONTEXT pDevice
+AW8624RamVerify(
+	PDEVICE_CONTEXT pDevice,
+	UINT16 BaseAddress,
+	ULONG Length,
+	PUINT16 Checksum
 )
 {
 	NTSTATUS Status = STATUS_SUCCESS;
+	UCHAR Chunk[AW8624_RAM_CHUNK_SIZE];
+	ULONG Offset = 0;
+	ULONG ChunkLength = 0;
+
+	*Checksum = 0;
+
+	AW8624WriteReg16WithCheck(pDevice, AW8624_REG16_RAMADDR, BaseAddress);
+
+	for (Offset = 0; Offset < Length; Offset += ChunkLength)
+	{
+		ChunkLength = min(Length - Offset, AW8624_RAM_CHUNK_SIZE);
+
+		AW8624ReadRegWithCheck(pDevice, AW8624_REG_RAMDATA, Chunk, ChunkLength);
 
+		*Checksum = (UINT16)(*Checksum + AW8624RamBankChecksum(Chunk, ChunkLength));
+	}
+
+	return Status;
+}
+
+NTSTATUS
+AW8624RamUpload(
+	PDEVICE_CONTEXT pDevice,
+	PUCHAR Bank,
+	ULONG Length
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	NTSTATUS ExitStatus = STATUS_SUCCESS;
+	UINT16 Checksum = 0;
+	UINT16 BaseAddress = 0;
+	PUCHAR Data = NULL;
+	ULONG DataLength = 0;
+	ULONG Offset = 0;
+	ULONG ChunkLength = 0;
+	SPB_WRITE_SEGMENT Segment;
 #ifdef DEBUG
-	Trace(TRACE_LEVEL_INFORMATION, TRACE_SPB, "%!FUNC!: Entry");
+	ULONG TransferCount = pDevice->I2CContext.TransferCount;
 #endif
 
-	Status = AW8624Standby(pDevice);
+	if (Length <= AW8624_RAM_BANK_HEADER_SIZE)
+	{
+		return STATUS_INVALID_BUFFER_SIZE;
+	}
+
+	Checksum = (UINT16)((Bank[0] << 8) | Bank[1]);
+	if (AW8624RamBankChecksum(&Bank[2], Length - 2) != Checksum)
+	{
+		return STATUS_FILE_CORRUPT_ERROR;
+	}
 
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_PWMDBG, AW8624_BIT_PWMDBG_PWM_MODE_MASK, AW8624_BIT_PWMDBG_PWM_24K);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_DETCTRL, AW8624_BIT_DETCTRL_PROTECT_MASK, AW8624_BIT_DETCTRL_PROTECT_NO_ACTION);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_PWMPRC, AW8624_BIT_PWMPRC_PRC_EN_MASK, AW8624_BIT_PWMPRC_PRC_DISABLE);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_PRLVL, AW8624_BIT_PRLVL_PR_EN_MASK, AW8624_BIT_PRLVL_PR_DISABLE);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_ADCTEST, AW8624_BIT_DETCTRL_VBAT_MODE_MASK, AW8624_BIT_DETCTRL_VBAT_HW_COMP);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_R_SPARE, AW8624_BIT_R_SPARE_MASK, AW8624_BIT_R_SPARE_ENABLE);
+	BaseAddress = (UINT16)((Bank[2] << 8) | Bank[3]);
+	Data = &Bank[AW8624_RAM_BANK_HEADER_SIZE];
+	DataLength = Length - AW8624_RAM_BANK_HEADER_SIZE;
+
+	if ((ULONG)BaseAddress + DataLength > AW8624_SRAM_SIZE)
+	{
+		return STATUS_INVALID_BUFFER_SIZE;
+	}
 
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_TRIM_LRA, 0x00);
+	pDevice->RamBankLoaded = FALSE;
 
-	Status = AW8624Standby(pDevice);
-	Status = AW8624RamMode(pDevice);
-	Status = AW8624Stop(pDevice);
+	//
+	// Once RAMINIT is set every step runs only while the previous ones
+	// succeeded, so that a bus error still falls through to clearing it
+	//
+	Status = AW8624WriteBits(pDevice, AW8624_REG_SYSCTRL, AW8624_BIT_SYSCTRL_RAMINIT_MASK, AW8624_BIT_SYSCTRL_RAMINIT_EN);
+
+	// Waveforms start at the base address, the RTP FIFO sits below it
+	if (NT_SUCCESS(Status))
+	{
+		Status = AW8624SpbWrite16(pDevice, AW8624_REG16_BASE_ADDR, BaseAddress);
+	}
+
+	if (NT_SUCCESS(Status))
+	{
+		Status = AW8624SpbWrite16(pDevice, AW8624_REG16_FIFO_AE, BaseAddress >> 1);
+	}
+
+	if (NT_SUCCESS(Status))
+	{
+		Status = AW8624SpbWrite16(pDevice, AW8624_REG16_FIFO_AF, BaseAddress - (BaseAddress >> 2));
+	}
+
+	// RAMADDR advances with every RAMDATA byte, so one pointer write covers the bank
+	if (NT_SUCCESS(Status))
+	{
+		Status = AW8624SpbWrite16(pDevice, AW8624_REG16_RAMADDR, BaseAddress);
+	}
+
+	for (Offset = 0; NT_SUCCESS(Status) && Offset < DataLength; Offset += ChunkLength)
+	{
+		ChunkLength = min(DataLength - Offset, AW8624_RAM_CHUNK_SIZE);
+
+		// RAMDATA is a data port, the chunk goes out straight from the bank buffer
+		Segment.Buffer = &Data[Offset];
+		Segment.Length = ChunkLength;
+
+		Status = SpbWriteDataGathered(&pDevice->I2CContext, AW8624_REG_RAMDATA, &Segment, 1);
+	}
+
+	if (NT_SUCCESS(Status))
+	{
+		Status = AW8624RamVerify(pDevice, BaseAddress, DataLength, &Checksum);
+	}
 
-	// from DTS (vib_sw_brake)
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_SW_BRAKE, 0x2C);
+	// Always leave RAMINIT, the chip cannot play while it is set
+	ExitStatus = AW8624WriteBits(pDevice, AW8624_REG_SYSCTRL, AW8624_BIT_SYSCTRL_RAMINIT_MASK, AW8624_BIT_SYSCTRL_RAMINIT_OFF);
 
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_THRS_BRA_END, 0x00);
+	if (NT_SUCCESS(Status))
+	{
+		Status = ExitStatus;
+	}
 
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_WAVECTRL, AW8624_BIT_WAVECTRL_NUM_OV_DRIVER_MASK, AW8624_BIT_WAVECTRL_NUM_OV_DRIVER);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
 
-	// from DTS (vib_cont_zc_thr)
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_ZC_THRSH_L, 0x8F8);
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_ZC_THRSH_H, 0x8F8 >> 8);
+	if ((UINT16)(Checksum + Bank[2] + Bank[3]) != (UINT16)((Bank[0] << 8) | Bank[1]))
+	{
+#ifdef DEBUG
+		Trace(TRACE_LEVEL_ERROR, TRACE_SPB, "%!FUNC!: SRAM readback checksum mismatch");
+#endif
+		return STATUS_CRC_ERROR;
+	}
 
-	// from DTS (vib_tset)
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_TSET, 0x11);
+	pDevice->RamBaseAddress = BaseAddress;
+	pDevice->RamBankLoaded = TRUE;
 
-	// from DTS (vib_bemf_config[0..3])
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_BEMF_VTHH_H, 0x00);
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_BEMF_VTHH_L, 0x08);
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_BEMF_VTHL_H, 0x03);
-	AW8624WriteRegWithCheck(pDevice, AW8624_REG_BEMF_VTHL_L, 0xF8);
+#ifdef DEBUG
+	Trace(
+		TRACE_LEVEL_INFORMATION,
+		TRACE_SPB,
+		"%!FUNC!: %lu bytes at 0x%04X in %lu bus transfers",
+		DataLength,
+		BaseAddress,
+		pDevice->I2CContext.TransferCount - TransferCount);
+#endif
 
 	return Status;
 }
 
 NTSTATUS
-AW8624SetupInterrupts(
+AW8624ReadRamBank(
+	PUCHAR* Bank,
+	PULONG Length
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	DECLARE_CONST_UNICODE_STRING(BankPath, AW8624_RAM_BANK_PATH);
+	OBJECT_ATTRIBUTES ObjectAttributes;
+	IO_STATUS_BLOCK IoStatus;
+	FILE_STANDARD_INFORMATION FileInformation;
+	HANDLE File = NULL;
+	PUCHAR Buffer = NULL;
+	ULONG FileLength = 0;
+
+	*Bank = NULL;
+	*Length = 0;
+
+	InitializeObjectAttributes(
+		&ObjectAttributes,
+		(PUNICODE_STRING)&BankPath,
+		OBJ_CASE_INSENSITIVE | OBJ_KERNEL_HANDLE,
+		NULL,
+		NULL);
+
+	Status = ZwCreateFile(
+		&File,
+		GENERIC_READ | SYNCHRONIZE,
+		&ObjectAttributes,
+		&IoStatus,
+		NULL,
+		FILE_ATTRIBUTE_NORMAL,
+		FILE_SHARE_READ,
+		FILE_OPEN,
+		FILE_SYNCHRONOUS_IO_NONALERT | FILE_NON_DIRECTORY_FILE,
+		NULL,
+		0);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+	Status = ZwQueryInformationFile(
+		File,
+		&IoStatus,
+		&FileInformation,
+		sizeof(FileInformation),
+		FileStandardInformation);
+	if (!NT_SUCCESS(Status))
+	{
+		goto exit;
+	}
+
+	if (FileInformation.EndOfFile.QuadPart <= AW8624_RAM_BANK_HEADER_SIZE ||
+		FileInformation.EndOfFile.QuadPart > AW8624_RAM_BANK_MAX_SIZE)
+	{
+		Status = STATUS_INVALID_BUFFER_SIZE;
+		goto exit;
+	}
+
+	FileLength = (ULONG)FileInformation.EndOfFile.QuadPart;
+
+	Buffer = (PUCHAR)ExAllocatePool2(POOL_FLAG_PAGED, FileLength, HAPTICS_POOL_TAG);
+	if (Buffer == NULL)
+	{
+		Status = STATUS_INSUFFICIENT_RESOURCES;
+		goto exit;
+	}
+
+	Status = ZwReadFile(File, NULL, NULL, NULL, &IoStatus, Buffer, FileLength, NULL, NULL);
+	if (NT_SUCCESS(Status) && IoStatus.Information != FileLength)
+	{
+		Status = STATUS_INVALID_BUFFER_SIZE;
+	}
+
+	if (!NT_SUCCESS(Status))
+	{
+		ExFreePoolWithTag(Buffer, HAPTICS_POOL_TAG);
+		goto exit;
+	}
+
+	*Bank = Buffer;
+	*Length = FileLength;
+
+exit:
+	ZwClose(File);
+
+	return Status;
+}
+
+NTSTATUS
+AW8624LoadRamBank(
 	PDEVICE_CONTEXT pDevice
 )
 {
 	NTSTATUS Status = STATUS_SUCCESS;
-	UINT16 RegData = 0;
+	PUCHAR Bank = NULL;
+	ULONG Length = 0;
+
+	Status = AW8624ReadRamBank(&Bank, &Length);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+	Status = AW8624RamUpload(pDevice, Bank, Length);
+
+	ExFreePoolWithTag(Bank, HAPTICS_POOL_TAG);
+
+	return Status;
+}
+
+VOID
+AW8624SetupWorkItem(
+	WDFWORKITEM WorkItem
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	PDEVICE_CONTEXT pDevice = DeviceGetContext(WdfWorkItemGetParentObject(WorkItem));
+
+	WdfWaitLockAcquire(pDevice->ControllerLock, NULL);
 
+	//
+	// Measuring f0 drives the motor and ends in standby, so it is left
+	// for the next initialization if a request is already playing
+	//
+	if (!pDevice->Calibrated && !pDevice->PlaybackActive && !pDevice->Blink.Active)
+	{
+		AW8624Calibrate(pDevice);
+	}
+
+	// A re-initialization may have queued this again after an earlier run
+	if (!pDevice->RamBankLoaded)
+	{
+		Status = AW8624LoadRamBank(pDevice);
+	}
+
+	WdfWaitLockRelease(pDevice->ControllerLock);
+
+	if (!NT_SUCCESS(Status))
+	{
+		// The waveform bank is optional, continuous mode works without it
 #ifdef DEBUG
-	Trace(TRACE_LEVEL_INFORMATION, TRACE_SPB, "%!FUNC!: Entry");
+		Trace(
+			TRACE_LEVEL_WARNING,
+			TRACE_INIT,
+			"%!FUNC!: No waveform bank loaded - 0x%08lX",
+			Status);
 #endif
+	}
+}
 
-	AW8624ReadRegWithCheck(pDevice, AW8624_REG_SYSINT, &RegData, sizeof(RegData));
+NTSTATUS
+AW8624CompileEffectChain(
+	PAW8624_EFFECT_CHAIN Chain,
+	PUCHAR Image
+)
+{
+	PAW8624_EFFECT_STEP Step = NULL;
+	ULONG i = 0;
 
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_DBGCTRL, AW8624_BIT_DBGCTRL_INTMODE_MASK, AW8624_BIT_DBGCTRL_INTN_EDGE_MODE);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_SYSINTM, AW8624_BIT_SYSINTM_UVLO_MASK, AW8624_BIT_SYSINTM_UVLO_EN);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_SYSINTM, AW8624_BIT_SYSINTM_OCD_MASK, AW8624_BIT_SYSINTM_OCD_EN);
-	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_SYSINTM, AW8624_BIT_SYSINTM_OT_MASK, AW8624_BIT_SYSINTM_OT_EN);
+	if (Chain->StepCount == 0 || Chain->StepCount > AW8624_EFFECT_CHAIN_STEPS ||
+		Chain->MainLoops > AW8624_BIT_MAIN_LOOP_INIFINITELY)
+	{
+		return STATUS_INVALID_PARAMETER;
+	}
 
-	return Status;
+	// Unused slots stay zero, which ends the sequence
+	RtlZeroMemory(Image, AW8624_EFFECT_CHAIN_IMAGE_SIZE);
+
+	for (i = 0; i < Chain->StepCount; i++)
+	{
+		Step = &Chain->Steps[i];
+
+		if ((Step->Effect & AW8624_BIT_WAVSEQ1_WAIT) ||
+			(!Step->Wait && Step->Effect == 0) ||
+			Step->Loops > AW8624_BIT_WAVLOOP_INIFINITELY)
+		{
+			return STATUS_INVALID_PARAMETER;
+		}
+
+		Image[i] = Step->Effect | (Step->Wait ? AW8624_BIT_WAVSEQ1_WAIT : 0);
+
+		// Two steps share each WAVLOOP register, odd steps in the high nibble
+		Image[AW8624_REG_WAVLOOP1 - AW8624_REG_WAVSEQ1 + i / 2] |=
+			(i % 2) ? Step->Loops : (UCHAR)(Step->Loops << 4);
+	}
+
+	Image[AW8624_REG_MAIN_LOOP - AW8624_REG_WAVSEQ1] = Chain->MainLoops;
+
+	return STATUS_SUCCESS;
+}
+
+//
+// Called with ControllerLock held
+//
+NTSTATUS
+AW8624PlayEffectChain(
+	PDEVICE_CONTEXT pDevice,
+	PAW8624_EFFECT_CHAIN Chain,
+	ULONG Intensity
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	UCHAR Image[AW8624_EFFECT_CHAIN_IMAGE_SIZE];
+
+	Status = AW8624CompileEffectChain(Chain, Image);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+	if (!pDevice->RamBankLoaded)
+	{
+		// Stopped by the caller, like any other HWN_ON
+		return AW8624VibrateUntilStopped(pDevice, Intensity);
+	}
+
+	Status = AW8624SetRamGain(pDevice, Intensity);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+	// The sequencer is only reprogrammed while idle
+	if (pDevice->PlaybackActive)
+	{
+		Status = AW8624Stop(pDevice);
+		if (!NT_SUCCESS(Status))
+		{
+			return Status;
+		}
+	}
+
+	//
+	// The sequencer registers are contiguous, so the whole chain is one
+	// burst and the chip plays it without further host involvement
+	//
+	AW8624WriteBurstWithCheck(pDevice, AW8624_REG_WAVSEQ1, Image, sizeof(Image));
+
+	Status = AW8624RamMode(pDevice);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+	pDevice->RamPlayback = TRUE;
+
+	return AW8624Go(pDevice);
+}
+
+//
+// HWN_ON, looped from the waveform bank once it is loaded and in
+// continuous mode before that. Called with ControllerLock held.
+//
+NTSTATUS
+AW8624Vibrate(
+	PDEVICE_CONTEXT pDevice,
+	ULONG Intensity
+)
+{
+	AW8624_EFFECT_CHAIN Chain;
+
+	if (!pDevice->RamBankLoaded)
+	{
+		return AW8624VibrateUntilStopped(pDevice, Intensity);
+	}
+
+	// Already looping, so an intensity change is all that was asked for
+	if (pDevice->PlaybackActive && pDevice->RamPlayback)
+	{
+		return AW8624SetRamGain(pDevice, Intensity);
+	}
+
+	RtlZeroMemory(&Chain, sizeof(Chain));
+	Chain.StepCount = 1;
+	Chain.Steps[0].Effect = AW8624_RAM_CONTINUOUS_EFFECT;
+	Chain.Steps[0].Loops = AW8624_BIT_WAVLOOP_INIFINITELY;
+
+	return AW8624PlayEffectChain(pDevice, &Chain, Intensity);
 }
 
 NTSTATUS
@@ -383,7 +2471,7 @@ AW8624Initialize(
 {
 	NTSTATUS Status = STATUS_SUCCESS;
 #ifdef DEBUG
-	UINT16 RegData = 0;
+	UINT8 RegData = 0;
 
 	Trace(TRACE_LEVEL_INFORMATION, TRACE_SPB, "%!FUNC!: Entry");
 
@@ -394,6 +2482,8 @@ AW8624Initialize(
 	// Soft reset
 	AW8624WriteRegWithCheck(pDevice, AW8624_REG_ID, 0xAA);
 
+	AW8624BuildDriveLevels(pDevice);
+
 	Status = AW8624SetupInterrupts(pDevice);
 	if (!NT_SUCCESS(Status))
 	{
@@ -406,5 +2496,31 @@ AW8624Initialize(
 		return Status;
 	}
 
+	Status = AW8624PrepareContinuousMode(pDevice);
+	if (!NT_SUCCESS(Status))
+	{
+		return Status;
+	}
+
+	//
+	// Calibration and the waveform bank upload run in the background.
+	// Until they finish, playback uses the DTS f0 and continuous mode.
+	//
+	if (pDevice->SetupWorkItem != NULL)
+	{
+		WdfWorkItemEnqueue(pDevice->SetupWorkItem);
+	}
+
+#ifdef DEBUG
+	Trace(
+		TRACE_LEVEL_INFORMATION,
+		TRACE_SPB,
+		"%!FUNC!: Register cache %lu hits, %lu misses, %lu bus transfers, %lu transfer allocations",
+		pDevice->RegisterCache.Hits,
+		pDevice->RegisterCache.Misses,
+		pDevice->I2CContext.TransferCount,
+		pDevice->I2CContext.AllocationCount);
+#endif
+
 	return Status;
 }
\ No newline at end of file
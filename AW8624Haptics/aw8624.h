@@ -134,6 +134,26 @@
 #define AW8624_REG_NUM_F0_2						0x7E
 #define AW8624_REG_NUM_F0_3						0x7F
 
+#define AW8624_REG_MAX							AW8624_REG_NUM_F0_3
+#define AW8624_REGISTER_COUNT					(AW8624_REG_MAX + 1)
+
+/* 16-bit values held in H/L register pairs, addressed by the high byte */
+#define AW8624_REG16_BASE_ADDR					AW8624_REG_BASE_ADDRH
+#define AW8624_REG16_FIFO_AE					AW8624_REG_FIFO_AEH
+#define AW8624_REG16_FIFO_AF					AW8624_REG_FIFO_AFH
+#define AW8624_REG16_END_DLY					AW8624_REG_END_DLY_H
+#define AW8624_REG16_RAMADDR					AW8624_REG_RAMADDRH
+#define AW8624_REG16_F_PRE						AW8624_REG_F_PRE_H
+#define AW8624_REG16_TD							AW8624_REG_TD_H
+#define AW8624_REG16_EF_WDATA					AW8624_REG_EF_WDATAH
+#define AW8624_REG16_EF_RDATA					AW8624_REG_EF_RDATAH
+#define AW8624_REG16_F_LRA_F0					AW8624_REG_F_LRA_F0_H
+#define AW8624_REG16_F_LRA_CONT					AW8624_REG_F_LRA_CONT_H
+#define AW8624_REG16_BEMF_VOL					AW8624_REG_BEMF_VOL_H
+#define AW8624_REG16_ZC_THRSH					AW8624_REG_ZC_THRSH_H
+#define AW8624_REG16_BEMF_VTHH					AW8624_REG_BEMF_VTHH_H
+#define AW8624_REG16_BEMF_VTHL					AW8624_REG_BEMF_VTHL_H
+
 /* SYSST 0x01 */
 #define AW8624_BIT_SYSST_OVS					(1 << 6)
 #define AW8624_BIT_SYSST_UVLS					(1 << 5)
@@ -151,6 +171,7 @@
 #define AW8624_BIT_SYSINT_OCDI					(1 << 2)
 #define AW8624_BIT_SYSINT_OTI					(1 << 1)
 #define AW8624_BIT_SYSINT_DONEI					(1 << 0)
+#define AW8624_SYSINT_COUNT						7
 
  /* SYSINTM 0x03 */
 #define AW8624_BIT_SYSINTM_OV_MASK				(~(1 << 6))
@@ -249,6 +270,10 @@
 #define AW8624_BIT_WAVLOOP4_SEQ7_MASK			(~(15 << 4))
 #define AW8624_BIT_WAVLOOP4_SEQ8_MASK			(~(15 << 0))
 
+ /* MAIN_LOOP 0x13 */
+#define AW8624_BIT_MAIN_LOOP_MASK				(~(15 << 0))
+#define AW8624_BIT_MAIN_LOOP_INIFINITELY		(15 << 0)
+
  /* PLAY_PRIO 0x1A */
 #define AW8624_BIT_PLAYPRIO_GO_MASK				(~(3 << 6))
 #define AW8624_BIT_PLAYPRIO_TRIG3_MASK			(~(3 << 4))
@@ -0,0 +1,223 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	BlinkTests.c
+
+Abstract:
+
+	HWN_BLINK edge timing against a simulated clock, and the DONE
+	interrupt each off edge raises.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+// Simulated time since the pattern started, in ms
+static ULONG Now;
+
+static VOID
+StartPattern(
+	ULONG PeriodMs,
+	ULONG DutyCycle,
+	ULONG CycleCount
+)
+{
+	HarnessInitializeDevice(&Device);
+	KeInitializeEvent(&Device.PlaybackDoneEvent, NotificationEvent, FALSE);
+
+	Device.Profile = AW8624DefaultProfile;
+	AW8624BuildProfileImage(&Device);
+	AW8624BuildDriveLevels(&Device);
+
+	Now = 0;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Blink(&Device, 0, PeriodMs, DutyCycle, CycleCount, 80));
+}
+
+static VOID
+StartBlink(
+	ULONG CycleCount
+)
+{
+	StartPattern(100, 50, CycleCount);
+
+	TEST_CHECK(Device.Blink.Active);
+	TEST_CHECK(Device.PlaybackActive);
+}
+
+// Time moves on to the timer, which fires, and the edge it queued runs
+static VOID
+RunEdge(
+	VOID
+)
+{
+	Now += (ULONG)(-HarnessTimerDueTime / 10000);
+	HarnessTimerDueTime = 0;
+
+	AW8624BlinkTimer(Device.Blink.Timer);
+	AW8624BlinkWorkItem(Device.Blink.WorkItem);
+}
+
+static VOID
+RaiseDone(
+	VOID
+)
+{
+	FakeChip.Registers[AW8624_REG_SYSINT] = AW8624_BIT_SYSINT_DONEI;
+	TEST_CHECK(AW8624InterruptService(&Device));
+}
+
+static VOID
+TimelyOffEdgeDoneIsConsumed(
+	VOID
+)
+{
+	StartBlink(0);
+
+	RunEdge();
+	TEST_CHECK(!Device.PlaybackActive);
+	TEST_CHECK(Device.Blink.OffEdgeDonePending);
+
+	RaiseDone();
+	TEST_CHECK(!Device.Blink.OffEdgeDonePending);
+
+	RunEdge();
+	TEST_CHECK(Device.PlaybackActive);
+
+	// A DONE no off edge is owed ends playback as usual
+	RaiseDone();
+	TEST_CHECK(!Device.PlaybackActive);
+	TEST_CHECK(Device.PlaybackDoneEvent.Signaled);
+}
+
+static VOID
+LateOffEdgeDoneKeepsTheNextEdgePlaying(
+	VOID
+)
+{
+	StartBlink(0);
+
+	// Off, then on again before the chip finished braking
+	RunEdge();
+	RunEdge();
+	TEST_CHECK(Device.PlaybackActive);
+	TEST_CHECK_EQUAL(AW8624_BIT_GO_ENABLE, FakeChip.Registers[AW8624_REG_GO]);
+
+	RaiseDone();
+	TEST_CHECK(Device.PlaybackActive);
+	TEST_CHECK(!Device.PlaybackDoneEvent.Signaled);
+	TEST_CHECK(!Device.Blink.OffEdgeDonePending);
+
+	// The last cycle still stops and waits for its own DONE
+	Device.Blink.CyclesLeft = 1;
+	KeSetEvent(&Device.PlaybackDoneEvent, IO_NO_INCREMENT, FALSE);
+
+	RunEdge();
+	TEST_CHECK(!Device.Blink.Active);
+	TEST_CHECK(!Device.PlaybackActive);
+	TEST_CHECK_EQUAL(0, Device.StopTimeouts);
+}
+
+static VOID
+EdgesFollowTheDutyCycle(
+	VOID
+)
+{
+	// Time of each edge, and whether GO is set after it
+	static const struct
+	{
+		ULONG Ms;
+		BOOLEAN On;
+	} Expected[] =
+	{
+		{ 30, FALSE },
+		{ 100, TRUE },
+		{ 130, FALSE },
+		{ 200, TRUE },
+		{ 230, FALSE },
+	};
+	ULONG i = 0;
+
+	StartPattern(100, 30, 3);
+	TEST_CHECK_EQUAL(AW8624_BIT_GO_ENABLE, FakeChip.Registers[AW8624_REG_GO]);
+
+	for (i = 0; i < ARRAYSIZE(Expected); i++)
+	{
+		TEST_CHECK(HarnessTimerDueTime < 0);
+
+		FakeChipClearLog();
+		RunEdge();
+
+		TEST_CHECK_EQUAL(Expected[i].Ms, Now);
+		TEST_CHECK_EQUAL(Expected[i].On ? AW8624_BIT_GO_ENABLE : AW8624_BIT_GO_DISABLE, FakeChip.Registers[AW8624_REG_GO]);
+
+		// Every edge but the last is a single write to GO
+		if (i + 1 < ARRAYSIZE(Expected))
+		{
+			TEST_CHECK_EQUAL(0, FakeChip.Reads);
+			TEST_CHECK_EQUAL(1, FakeChip.Writes);
+			TEST_CHECK_EQUAL(AW8624_REG_GO, FakeChip.Log[0].Address);
+		}
+	}
+
+	// Three cycles of five edges, then the pattern stops for good
+	TEST_CHECK(!Device.Blink.Active);
+	TEST_CHECK_EQUAL(0, HarnessTimerDueTime);
+	TEST_CHECK_EQUAL(HWN_OFF, Device.PreviousState);
+	TEST_CHECK_EQUAL(5, Device.Blink.Edges);
+}
+
+static VOID
+ReplacedPatternDropsItsQueuedEdge(
+	VOID
+)
+{
+	StartBlink(0);
+
+	// The timer queues an edge, then a new request cancels the pattern
+	AW8624BlinkTimer(Device.Blink.Timer);
+	AW8624BlinkCancel(&Device);
+	TEST_CHECK_EQUAL(0, HarnessTimerDueTime);
+
+	Device.Blink.Active = TRUE;
+	FakeChipClearLog();
+
+	AW8624BlinkWorkItem(Device.Blink.WorkItem);
+	TEST_CHECK_EQUAL(0, FakeChip.Reads + FakeChip.Writes);
+	TEST_CHECK_EQUAL(0, HarnessTimerDueTime);
+}
+
+static VOID
+DegenerateDutyCyclesNeedNoTimer(
+	VOID
+)
+{
+	StartPattern(100, 0, 0);
+	TEST_CHECK(!Device.Blink.Active);
+	TEST_CHECK(!Device.PlaybackActive);
+	TEST_CHECK_EQUAL(0, HarnessTimerDueTime);
+
+	StartPattern(100, 100, 0);
+	TEST_CHECK(!Device.Blink.Active);
+	TEST_CHECK(Device.PlaybackActive);
+	TEST_CHECK_EQUAL(0, HarnessTimerDueTime);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(EdgesFollowTheDutyCycle);
+	TEST_RUN(ReplacedPatternDropsItsQueuedEdge);
+	TEST_RUN(DegenerateDutyCyclesNeedNoTimer);
+	TEST_RUN(TimelyOffEdgeDoneIsConsumed);
+	TEST_RUN(LateOffEdgeDoneKeepsTheNextEdgePlaying);
+
+	return TestFailures != 0;
+}
@@ -0,0 +1,190 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	CacheTests.c
+
+Abstract:
+
+	The register cache: which registers it holds, when it is dropped,
+	and the transfers and hit rate of repeated HWN_ON/HWN_OFF cycles.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+static VOID
+PrepareDevice(
+	VOID
+)
+{
+	HarnessInitializeDevice(&Device);
+	KeInitializeEvent(&Device.PlaybackDoneEvent, NotificationEvent, FALSE);
+
+	Device.Profile = AW8624DefaultProfile;
+	AW8624BuildProfileImage(&Device);
+	AW8624BuildDriveLevels(&Device);
+}
+
+static VOID
+WriteBitsReadsOnlyOnMiss(
+	VOID
+)
+{
+	PrepareDevice();
+	FakeChip.Registers[AW8624_REG_PWMDBG] = 0x80;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624WriteBits(&Device, AW8624_REG_PWMDBG, 0xF0, 0x01));
+	TEST_CHECK_EQUAL(1, FakeChip.Reads);
+	TEST_CHECK_EQUAL(1, FakeChip.Writes);
+	TEST_CHECK_EQUAL(1, Device.RegisterCache.Misses);
+
+	// Later updates merge into the cached value
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624WriteBits(&Device, AW8624_REG_PWMDBG, 0x8F, 0x20));
+	TEST_CHECK_EQUAL(1, FakeChip.Reads);
+	TEST_CHECK_EQUAL(2, FakeChip.Writes);
+	TEST_CHECK_EQUAL(1, Device.RegisterCache.Hits);
+	TEST_CHECK_EQUAL(0xA1, FakeChip.Registers[AW8624_REG_PWMDBG]);
+
+	// Nothing to change, nothing on the bus
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624WriteBits(&Device, AW8624_REG_PWMDBG, 0x8F, 0x20));
+	TEST_CHECK_EQUAL(1, FakeChip.Reads);
+	TEST_CHECK_EQUAL(2, FakeChip.Writes);
+	TEST_CHECK_EQUAL(2, Device.RegisterCache.Hits);
+}
+
+static VOID
+VolatileRegistersAlwaysReachTheBus(
+	VOID
+)
+{
+	PrepareDevice();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624WriteBits(&Device, AW8624_REG_GO, 0xFE, AW8624_BIT_GO_DISABLE));
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624WriteBits(&Device, AW8624_REG_GO, 0xFE, AW8624_BIT_GO_DISABLE));
+	TEST_CHECK_EQUAL(2, FakeChip.Reads);
+	TEST_CHECK_EQUAL(2, FakeChip.Writes);
+	TEST_CHECK_EQUAL(0, Device.RegisterCache.Hits);
+	TEST_CHECK(!Device.RegisterCache.Valid[AW8624_REG_GO]);
+}
+
+static VOID
+DataPortBurstsAreNotCached(
+	VOID
+)
+{
+	UCHAR Samples[4] = { 1, 2, 3, 4 };
+
+	PrepareDevice();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624SpbWriteBurst(&Device, AW8624_REG_RAMDATA, Samples, sizeof(Samples)));
+
+	// The samples all went to the port, not to the registers after it
+	TEST_CHECK(!Device.RegisterCache.Valid[AW8624_REG_RAMDATA + 1]);
+	TEST_CHECK(!Device.RegisterCache.Valid[AW8624_REG_RAMDATA + 3]);
+}
+
+static VOID
+SoftResetDropsTheCache(
+	VOID
+)
+{
+	PrepareDevice();
+
+	AW8624SpbWrite(&Device, AW8624_REG_PWMDBG, 0x11);
+	Device.ContinuousModePrepared = TRUE;
+	Device.RamBankLoaded = TRUE;
+
+	TEST_CHECK(Device.RegisterCache.Valid[AW8624_REG_PWMDBG]);
+
+	AW8624SpbWrite(&Device, AW8624_REG_ID, 0xAA);
+
+	TEST_CHECK(!Device.RegisterCache.Valid[AW8624_REG_PWMDBG]);
+	TEST_CHECK(!Device.ContinuousModePrepared);
+	TEST_CHECK(!Device.RamBankLoaded);
+
+	FakeChipClearLog();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624WriteBits(&Device, AW8624_REG_PWMDBG, 0xF0, 0x01));
+	TEST_CHECK_EQUAL(1, FakeChip.Reads);
+}
+
+static VOID
+OnOffCyclesRunFromTheCache(
+	VOID
+)
+{
+	ULONG FirstTransfers = 0;
+	ULONG Transfers = 0;
+	ULONG Hits = 0;
+	ULONG Misses = 0;
+	ULONG i = 0;
+	ULONG j = 0;
+
+	PrepareDevice();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Initialize(&Device));
+
+	Hits = Device.RegisterCache.Hits;
+	Misses = Device.RegisterCache.Misses;
+
+	for (i = 0; i < 4; i++)
+	{
+		FakeChipClearLog();
+
+		TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Vibrate(&Device, 100));
+
+		// DONE arrives while braking
+		KeSetEvent(&Device.PlaybackDoneEvent, IO_NO_INCREMENT, FALSE);
+
+		TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Stop(&Device));
+
+		Transfers = FakeChip.Reads + FakeChip.Writes;
+
+		if (i == 0)
+		{
+			FirstTransfers = Transfers;
+			continue;
+		}
+
+		//
+		// Once warm, the only read left is acknowledging SYSINT on
+		// activation, and a cycle never grows
+		//
+		TEST_CHECK_EQUAL(1, FakeChip.Reads);
+		TEST_CHECK(Transfers <= FirstTransfers);
+
+		for (j = 0; j < FakeChip.LogCount; j++)
+		{
+			TEST_CHECK(FakeChip.Log[j].Write || FakeChip.Log[j].Address == AW8624_REG_SYSINT);
+		}
+	}
+
+	Hits = Device.RegisterCache.Hits - Hits;
+	Misses = Device.RegisterCache.Misses - Misses;
+
+	TEST_CHECK(Hits > Misses);
+
+	printf(
+		"On/off cycle: %u transfers, cache hit rate %u%%\n",
+		Transfers,
+		Hits * 100 / (Hits + Misses));
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(WriteBitsReadsOnlyOnMiss);
+	TEST_RUN(VolatileRegistersAlwaysReachTheBus);
+	TEST_RUN(DataPortBurstsAreNotCached);
+	TEST_RUN(SoftResetDropsTheCache);
+	TEST_RUN(OnOffCyclesRunFromTheCache);
+
+	return TestFailures != 0;
+}
@@ -0,0 +1,231 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	CalibrationTests.c
+
+Abstract:
+
+	AW8624RoundDiv, and the TRIM_LRA search against a simulated LRA
+	whose resonance moves by 0.25% per trim step, run from the setup
+	work item.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+// Untrimmed resonance of the simulated LRA, in 0.1 Hz
+static LONG NaturalF0;
+
+static LONG
+TrimCode(
+	UINT8 Register
+)
+{
+	LONG Code = Register & AW8624_TRIM_LRA_CODE_MASK;
+
+	return (Code & 0x10) ? Code - 0x20 : Code;
+}
+
+static LONG
+TrimmedF0(
+	LONG Code
+)
+{
+	return NaturalF0 * (AW8624_TRIM_LRA_STEPS_PER_UNIT - Code) / AW8624_TRIM_LRA_STEPS_PER_UNIT;
+}
+
+static VOID
+MeasureResonance(
+	UCHAR Address,
+	ULONG Length
+)
+{
+	ULONG Period = 0;
+
+	UNREFERENCED_PARAMETER(Length);
+
+	if (Address != AW8624_REG16_F_LRA_F0)
+	{
+		return;
+	}
+
+	Period = 1000000000UL / ((ULONG)TrimmedF0(TrimCode(FakeChip.Registers[AW8624_REG_TRIM_LRA])) * Device.Profile.F0Coeff);
+
+	FakeChip.Registers[AW8624_REG_F_LRA_F0_H] = (UCHAR)(Period >> 8);
+	FakeChip.Registers[AW8624_REG_F_LRA_F0_L] = (UCHAR)(Period & 0xFF);
+}
+
+static VOID
+PrepareDevice(
+	LONG F0
+)
+{
+	HarnessInitializeDevice(&Device);
+	KeInitializeEvent(&Device.PlaybackDoneEvent, NotificationEvent, FALSE);
+
+	Device.Profile = AW8624DefaultProfile;
+	AW8624BuildProfileImage(&Device);
+	AW8624BuildDriveLevels(&Device);
+
+	NaturalF0 = F0;
+	FakeChip.ReadHook = MeasureResonance;
+}
+
+static VOID
+RoundDivRoundsHalfAwayFromZero(
+	VOID
+)
+{
+	TEST_CHECK_EQUAL(3, AW8624RoundDiv(5, 2));
+	TEST_CHECK_EQUAL(-3, AW8624RoundDiv(-5, 2));
+	TEST_CHECK_EQUAL(-3, AW8624RoundDiv(5, -2));
+	TEST_CHECK_EQUAL(3, AW8624RoundDiv(-5, -2));
+	TEST_CHECK_EQUAL(2, AW8624RoundDiv(4, 2));
+	TEST_CHECK_EQUAL(0, AW8624RoundDiv(1, 3));
+	TEST_CHECK_EQUAL(1, AW8624RoundDiv(2, 3));
+	TEST_CHECK_EQUAL(-1, AW8624RoundDiv(-2, 3));
+	TEST_CHECK_EQUAL(0, AW8624RoundDiv(0, 7));
+}
+
+static VOID
+SearchTrimConverges(
+	VOID
+)
+{
+	static const LONG NaturalF0s[] = { 2050, 2000, 2100, 2080, 1990, 2150, 1960 };
+	LONG Preset = (LONG)AW8624DefaultProfile.F0Preset;
+	LONG Tolerance = Preset / (2 * AW8624_TRIM_LRA_STEPS_PER_UNIT);
+	LONG Trim = 0;
+	LONG Best = 0;
+	LONG Code = 0;
+	ULONG i = 0;
+
+	for (i = 0; i < ARRAYSIZE(NaturalF0s); i++)
+	{
+		PrepareDevice(NaturalF0s[i]);
+
+		// The closest any code gets, measurement rounding aside
+		Best = AW8624_TRIM_LRA_MIN;
+		for (Code = AW8624_TRIM_LRA_MIN; Code <= AW8624_TRIM_LRA_MAX; Code++)
+		{
+			if (abs(TrimmedF0(Code) - Preset) < abs(TrimmedF0(Best) - Preset))
+			{
+				Best = Code;
+			}
+		}
+
+		TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624SearchTrim(&Device, &Trim));
+		TEST_CHECK(abs(TrimmedF0(Trim) - Preset) <= max(Tolerance, abs(TrimmedF0(Best) - Preset)) + 1);
+		TEST_CHECK(FakeChipWritesTo(AW8624_REG_TRIM_LRA) <= AW8624_TRIM_MAX_MEASUREMENTS);
+	}
+}
+
+static VOID
+SearchTrimClampsOutOfRange(
+	VOID
+)
+{
+	LONG Trim = 0;
+
+	// Beyond what 0.25% steps can reach, the search ends on the range limit
+	PrepareDevice(2400);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624SearchTrim(&Device, &Trim));
+	TEST_CHECK_EQUAL(AW8624_TRIM_LRA_MAX, Trim);
+
+	PrepareDevice(1800);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624SearchTrim(&Device, &Trim));
+	TEST_CHECK_EQUAL(AW8624_TRIM_LRA_MIN, Trim);
+}
+
+static VOID
+CalibrateProgramsTrimAndPeriod(
+	VOID
+)
+{
+	LONG Preset = (LONG)AW8624DefaultProfile.F0Preset;
+
+	PrepareDevice(2110);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Calibrate(&Device));
+	TEST_CHECK_EQUAL(Device.TrimLra, FakeChip.Registers[AW8624_REG_TRIM_LRA]);
+	TEST_CHECK(abs((LONG)Device.F0 - Preset) <= Preset / (2 * AW8624_TRIM_LRA_STEPS_PER_UNIT) + 1);
+	TEST_CHECK_EQUAL(AW8624F0Period(&Device, Device.F0) >> 8, Device.ProfileImage.Timing[0]);
+	TEST_CHECK_EQUAL(AW8624F0Period(&Device, Device.F0) & 0xFF, Device.ProfileImage.Timing[1]);
+}
+
+static VOID
+FailedCalibrationIsRetried(
+	VOID
+)
+{
+	PrepareDevice(2110);
+
+	// No measurement result, F_LRA_F0 reads back as zero
+	FakeChip.ReadHook = NULL;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Calibrate(&Device));
+	TEST_CHECK(!Device.Calibrated);
+	TEST_CHECK_EQUAL(AW8624DefaultProfile.F0Preset, Device.F0);
+	TEST_CHECK_EQUAL(0, FakeChip.Registers[AW8624_REG_TRIM_LRA]);
+
+	FakeChip.ReadHook = MeasureResonance;
+	FakeChipClearLog();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Calibrate(&Device));
+	TEST_CHECK(Device.Calibrated);
+	TEST_CHECK(FakeChipWritesTo(AW8624_REG_GO) > 0);
+
+	// Calibrated units are not measured again
+	FakeChipClearLog();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Calibrate(&Device));
+	TEST_CHECK_EQUAL(0, FakeChip.Reads + FakeChip.Writes);
+}
+
+static VOID
+CalibrationRunsFromSetupWorkItem(
+	VOID
+)
+{
+	PrepareDevice(2110);
+	Device.SetupWorkItem = (WDFWORKITEM)&Device;
+
+	// Initialization only queues the measurement
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Initialize(&Device));
+	TEST_CHECK_EQUAL(1, HarnessWorkItemsQueued);
+	TEST_CHECK(!Device.Calibrated);
+	TEST_CHECK_EQUAL(0, FakeChip.Registers[AW8624_REG_TRIM_LRA]);
+
+	// Not while a request is playing
+	Device.PlaybackActive = TRUE;
+	AW8624SetupWorkItem(Device.SetupWorkItem);
+	TEST_CHECK(!Device.Calibrated);
+
+	Device.PlaybackActive = FALSE;
+	AW8624SetupWorkItem(Device.SetupWorkItem);
+	TEST_CHECK(Device.Calibrated);
+	TEST_CHECK_EQUAL(Device.TrimLra, FakeChip.Registers[AW8624_REG_TRIM_LRA]);
+	TEST_CHECK(!Device.ContinuousModePrepared);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(RoundDivRoundsHalfAwayFromZero);
+	TEST_RUN(SearchTrimConverges);
+	TEST_RUN(SearchTrimClampsOutOfRange);
+	TEST_RUN(CalibrateProgramsTrimAndPeriod);
+	TEST_RUN(FailedCalibrationIsRetried);
+	TEST_RUN(CalibrationRunsFromSetupWorkItem);
+
+	return TestFailures != 0;
+}
@@ -0,0 +1,214 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	ContinuousModeTests.c
+
+Abstract:
+
+	Register image AW8624PrepareContinuousMode leaves in the chip, and
+	the transfers from HWN_ON to GO with and without it in place.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+static VOID
+PrepareDevice(
+	VOID
+)
+{
+	HarnessInitializeDevice(&Device);
+	KeInitializeEvent(&Device.PlaybackDoneEvent, NotificationEvent, FALSE);
+
+	Device.Profile = AW8624DefaultProfile;
+	AW8624BuildProfileImage(&Device);
+	AW8624BuildDriveLevels(&Device);
+}
+
+//
+// A device through initialization, with continuous mode prepared and
+// the bus log cleared
+//
+static VOID
+PrepareInitializedDevice(
+	VOID
+)
+{
+	PrepareDevice();
+	Device.SetupWorkItem = (WDFWORKITEM)&Device;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Initialize(&Device));
+	TEST_CHECK(Device.ContinuousModePrepared);
+
+	FakeChipClearLog();
+}
+
+//
+// Transfers up to and including the one that sets GO
+//
+static ULONG
+TransfersToGo(
+	VOID
+)
+{
+	ULONG i = 0;
+
+	for (i = 0; i < FakeChip.LogCount; i++)
+	{
+		if (FakeChip.Log[i].Write &&
+			FakeChip.Log[i].Address == AW8624_REG_GO &&
+			FakeChip.Log[i].Data[0] == AW8624_BIT_GO_ENABLE)
+		{
+			return i + 1;
+		}
+	}
+
+	return 0;
+}
+
+static VOID
+ContinuousModeRunsClosedLoop(
+	VOID
+)
+{
+	PrepareDevice();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624PrepareContinuousMode(&Device));
+	TEST_CHECK_EQUAL(
+		AW8624_BIT_CONT_CTRL_ZC_DETEC_ENABLE |
+		AW8624_BIT_CONT_CTRL_WAIT_1PERIOD |
+		AW8624_BIT_CONT_CTRL_BY_GO_SIGNAL |
+		AW8624_BIT_CONT_CTRL_CLOSE_PLAYBACK |
+		AW8624_BIT_CONT_CTRL_F0_DETECT_DISABLE |
+		AW8624_BIT_CONT_CTRL_O2C_DISABLE |
+		AW8624_BIT_CONT_CTRL_AUTO_BRK_ENABLE,
+		FakeChip.Registers[AW8624_REG_CONT_CTRL]);
+}
+
+static VOID
+BrakeCountGoesToBemfNum(
+	VOID
+)
+{
+	PrepareDevice();
+	FakeChip.Registers[AW8624_REG_BEMF_NUM] = 0x50;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624PrepareContinuousMode(&Device));
+	TEST_CHECK_EQUAL(0x50 | AW8624DefaultProfile.ContNumBrk, FakeChip.Registers[AW8624_REG_BEMF_NUM]);
+}
+
+static VOID
+HotStartIsModeSelectAndGo(
+	VOID
+)
+{
+	static const UCHAR Expected[] =
+	{
+		AW8624_REG_SYSCTRL,
+		AW8624_REG_DBGCTRL,
+		AW8624_REG_SYSINT,
+		AW8624_REG_SYSINTM,
+		AW8624_REG_GO,
+	};
+	ULONG Cycle = 0;
+	ULONG i = 0;
+
+	PrepareInitializedDevice();
+
+	for (Cycle = 0; Cycle < 2; Cycle++)
+	{
+		TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Vibrate(&Device, 100));
+
+		// Wake up in continuous mode, acknowledge SYSINT, unmask UVLO, GO
+		TEST_CHECK_EQUAL(ARRAYSIZE(Expected), FakeChip.LogCount);
+		TEST_CHECK_EQUAL(ARRAYSIZE(Expected), TransfersToGo());
+
+		for (i = 0; i < min(ARRAYSIZE(Expected), FakeChip.LogCount); i++)
+		{
+			TEST_CHECK_EQUAL(Expected[i], FakeChip.Log[i].Address);
+		}
+
+		TEST_CHECK_EQUAL(0, FakeChipWritesTo(AW8624_REG_F_PRE_H));
+		TEST_CHECK_EQUAL(0, FakeChipWritesTo(AW8624_REG_CONT_CTRL));
+		TEST_CHECK_EQUAL(0, FakeChipWritesTo(AW8624_REG_ZC_THRSH_H));
+
+		// DONE arrives while braking
+		KeSetEvent(&Device.PlaybackDoneEvent, IO_NO_INCREMENT, FALSE);
+		TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Stop(&Device));
+
+		FakeChipClearLog();
+	}
+}
+
+static VOID
+ResetStartPreparesFirst(
+	VOID
+)
+{
+	PrepareInitializedDevice();
+
+	// Any write to ID resets the register map
+	AW8624SpbWrite(&Device, AW8624_REG_ID, 0xAA);
+	TEST_CHECK(!Device.ContinuousModePrepared);
+
+	FakeChipClearLog();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Vibrate(&Device, 100));
+	TEST_CHECK(Device.ContinuousModePrepared);
+	TEST_CHECK_EQUAL(1, FakeChipWritesTo(AW8624_REG_F_PRE_H));
+	TEST_CHECK_EQUAL(1, FakeChipWritesTo(AW8624_REG_ZC_THRSH_H));
+	TEST_CHECK_EQUAL(FakeChip.LogCount, TransfersToGo());
+}
+
+static VOID
+HotStartBenchmark(
+	VOID
+)
+{
+	ULONG HotTransfers = 0;
+	ULONG HotMicroseconds = 0;
+	ULONG ColdTransfers = 0;
+	ULONG ColdMicroseconds = 0;
+
+	PrepareInitializedDevice();
+	AW8624Vibrate(&Device, 100);
+
+	HotTransfers = TransfersToGo();
+	HotMicroseconds = FakeChipBusMicroseconds();
+
+	// What every HWN_ON cost before the parameters were kept programmed
+	PrepareInitializedDevice();
+	Device.ContinuousModePrepared = FALSE;
+	AW8624Vibrate(&Device, 100);
+
+	ColdTransfers = TransfersToGo();
+	ColdMicroseconds = FakeChipBusMicroseconds();
+
+	TEST_CHECK(HotTransfers < ColdTransfers);
+
+	printf(
+		"HWN_ON to GO: prepared %u transfers, %u us; unprepared %u transfers, %u us\n",
+		HotTransfers,
+		HotMicroseconds,
+		ColdTransfers,
+		ColdMicroseconds);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(ContinuousModeRunsClosedLoop);
+	TEST_RUN(BrakeCountGoesToBemfNum);
+	TEST_RUN(HotStartIsModeSelectAndGo);
+	TEST_RUN(ResetStartPreparesFirst);
+	TEST_RUN(HotStartBenchmark);
+
+	return TestFailures != 0;
+}
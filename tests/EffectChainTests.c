@@ -0,0 +1,221 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	EffectChainTests.c
+
+Abstract:
+
+	AW8624CompileEffectChain images, and HWN_ON choosing between the
+	waveform bank and continuous mode.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+#define WAVLOOP(n) (AW8624_REG_WAVLOOP1 - AW8624_REG_WAVSEQ1 + (n))
+#define MAIN_LOOP (AW8624_REG_MAIN_LOOP - AW8624_REG_WAVSEQ1)
+
+static VOID
+SingleStepFillsFirstSlots(
+	VOID
+)
+{
+	AW8624_EFFECT_CHAIN Chain;
+	UCHAR Image[AW8624_EFFECT_CHAIN_IMAGE_SIZE];
+	ULONG i = 0;
+
+	RtlZeroMemory(&Chain, sizeof(Chain));
+	Chain.StepCount = 1;
+	Chain.Steps[0].Effect = 3;
+	Chain.Steps[0].Loops = 2;
+	Chain.MainLoops = 1;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624CompileEffectChain(&Chain, Image));
+	TEST_CHECK_EQUAL(3, Image[0]);
+	TEST_CHECK_EQUAL(0x20, Image[WAVLOOP(0)]);
+	TEST_CHECK_EQUAL(1, Image[MAIN_LOOP]);
+
+	// Every other slot is zero, which ends the sequence after step one
+	for (i = 1; i < AW8624_EFFECT_CHAIN_STEPS; i++)
+	{
+		TEST_CHECK_EQUAL(0, Image[i]);
+	}
+
+	for (i = 1; i < AW8624_EFFECT_CHAIN_STEPS / 2; i++)
+	{
+		TEST_CHECK_EQUAL(0, Image[WAVLOOP(i)]);
+	}
+}
+
+static VOID
+StepsShareLoopRegistersInPairs(
+	VOID
+)
+{
+	AW8624_EFFECT_CHAIN Chain;
+	UCHAR Image[AW8624_EFFECT_CHAIN_IMAGE_SIZE];
+	ULONG i = 0;
+
+	RtlZeroMemory(&Chain, sizeof(Chain));
+	Chain.StepCount = AW8624_EFFECT_CHAIN_STEPS;
+
+	for (i = 0; i < AW8624_EFFECT_CHAIN_STEPS; i++)
+	{
+		Chain.Steps[i].Effect = (UINT8)(i + 1);
+		Chain.Steps[i].Loops = (UINT8)(i + 1);
+	}
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624CompileEffectChain(&Chain, Image));
+
+	for (i = 0; i < AW8624_EFFECT_CHAIN_STEPS; i++)
+	{
+		TEST_CHECK_EQUAL(i + 1, Image[i]);
+	}
+
+	// The first step of each pair goes in the high nibble
+	TEST_CHECK_EQUAL(0x12, Image[WAVLOOP(0)]);
+	TEST_CHECK_EQUAL(0x34, Image[WAVLOOP(1)]);
+	TEST_CHECK_EQUAL(0x56, Image[WAVLOOP(2)]);
+	TEST_CHECK_EQUAL(0x78, Image[WAVLOOP(3)]);
+	TEST_CHECK_EQUAL(0, Image[MAIN_LOOP]);
+}
+
+static VOID
+WaitStepsSetTheWaitBit(
+	VOID
+)
+{
+	AW8624_EFFECT_CHAIN Chain;
+	UCHAR Image[AW8624_EFFECT_CHAIN_IMAGE_SIZE];
+
+	RtlZeroMemory(&Chain, sizeof(Chain));
+	Chain.StepCount = 3;
+	Chain.Steps[0].Effect = 1;
+	Chain.Steps[1].Effect = 0x10;
+	Chain.Steps[1].Wait = TRUE;
+	Chain.Steps[2].Effect = 2;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624CompileEffectChain(&Chain, Image));
+	TEST_CHECK_EQUAL(1, Image[0]);
+	TEST_CHECK_EQUAL(AW8624_BIT_WAVSEQ1_WAIT | 0x10, Image[1]);
+	TEST_CHECK_EQUAL(2, Image[2]);
+}
+
+static VOID
+InvalidChainsAreRejected(
+	VOID
+)
+{
+	AW8624_EFFECT_CHAIN Chain;
+	UCHAR Image[AW8624_EFFECT_CHAIN_IMAGE_SIZE];
+
+	RtlZeroMemory(&Chain, sizeof(Chain));
+	TEST_CHECK_EQUAL(STATUS_INVALID_PARAMETER, AW8624CompileEffectChain(&Chain, Image));
+
+	Chain.StepCount = AW8624_EFFECT_CHAIN_STEPS + 1;
+	TEST_CHECK_EQUAL(STATUS_INVALID_PARAMETER, AW8624CompileEffectChain(&Chain, Image));
+
+	Chain.StepCount = 1;
+	Chain.Steps[0].Effect = 1;
+	Chain.MainLoops = AW8624_BIT_MAIN_LOOP_INIFINITELY + 1;
+	TEST_CHECK_EQUAL(STATUS_INVALID_PARAMETER, AW8624CompileEffectChain(&Chain, Image));
+
+	Chain.MainLoops = 0;
+	Chain.Steps[0].Loops = AW8624_BIT_WAVLOOP_INIFINITELY + 1;
+	TEST_CHECK_EQUAL(STATUS_INVALID_PARAMETER, AW8624CompileEffectChain(&Chain, Image));
+
+	// Index 0 would end the sequence, the wait bit belongs to Wait
+	Chain.Steps[0].Loops = 0;
+	Chain.Steps[0].Effect = 0;
+	TEST_CHECK_EQUAL(STATUS_INVALID_PARAMETER, AW8624CompileEffectChain(&Chain, Image));
+
+	Chain.Steps[0].Effect = AW8624_BIT_WAVSEQ1_WAIT | 1;
+	TEST_CHECK_EQUAL(STATUS_INVALID_PARAMETER, AW8624CompileEffectChain(&Chain, Image));
+}
+
+static VOID
+PrepareDevice(
+	BOOLEAN RamBankLoaded
+)
+{
+	HarnessInitializeDevice(&Device);
+	KeInitializeEvent(&Device.PlaybackDoneEvent, NotificationEvent, FALSE);
+
+	Device.Profile = AW8624DefaultProfile;
+	AW8624BuildProfileImage(&Device);
+	AW8624BuildDriveLevels(&Device);
+	Device.RamBankLoaded = RamBankLoaded;
+}
+
+static VOID
+VibrateUsesContinuousModeWithoutBank(
+	VOID
+)
+{
+	PrepareDevice(FALSE);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Vibrate(&Device, 100));
+	TEST_CHECK(Device.PlaybackActive);
+	TEST_CHECK(!Device.RamPlayback);
+	TEST_CHECK_EQUAL(AW8624_BIT_SYSCTRL_PLAY_MODE_CONT, FakeChip.Registers[AW8624_REG_SYSCTRL] & ~AW8624_BIT_SYSCTRL_PLAY_MODE_MASK);
+	TEST_CHECK_EQUAL(0, FakeChipWritesTo(AW8624_REG_WAVSEQ1));
+}
+
+static VOID
+VibrateLoopsBankWaveform(
+	VOID
+)
+{
+	PrepareDevice(TRUE);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Vibrate(&Device, 50));
+	TEST_CHECK(Device.PlaybackActive);
+	TEST_CHECK(Device.RamPlayback);
+	TEST_CHECK_EQUAL(AW8624_BIT_SYSCTRL_PLAY_MODE_RAM, FakeChip.Registers[AW8624_REG_SYSCTRL] & ~AW8624_BIT_SYSCTRL_PLAY_MODE_MASK);
+	TEST_CHECK_EQUAL(AW8624_BIT_GO_ENABLE, FakeChip.Registers[AW8624_REG_GO]);
+
+	// The whole chain is one burst
+	TEST_CHECK_EQUAL(1, FakeChipWritesTo(AW8624_REG_WAVSEQ1));
+	TEST_CHECK_EQUAL(1, FakeChipWritesTo(AW8624_REG_MAIN_LOOP));
+	TEST_CHECK_EQUAL(AW8624_RAM_CONTINUOUS_EFFECT, FakeChip.Registers[AW8624_REG_WAVSEQ1]);
+	TEST_CHECK_EQUAL(AW8624_BIT_WAVLOOP_INIFINITELY << 4, FakeChip.Registers[AW8624_REG_WAVLOOP1]);
+	TEST_CHECK_EQUAL(AW8624_RAM_GAIN_MAX / 2, FakeChip.Registers[AW8624_REG_DATDBG]);
+}
+
+static VOID
+VibrateWhileLoopingOnlyChangesGain(
+	VOID
+)
+{
+	PrepareDevice(TRUE);
+
+	AW8624Vibrate(&Device, 100);
+	FakeChipClearLog();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Vibrate(&Device, 25));
+	TEST_CHECK_EQUAL(1, FakeChip.Writes);
+	TEST_CHECK_EQUAL(1, FakeChipWritesTo(AW8624_REG_DATDBG));
+	TEST_CHECK_EQUAL(AW8624_RAM_GAIN_MAX / 4, FakeChip.Registers[AW8624_REG_DATDBG]);
+	TEST_CHECK(Device.PlaybackActive);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(SingleStepFillsFirstSlots);
+	TEST_RUN(StepsShareLoopRegistersInPairs);
+	TEST_RUN(WaitStepsSetTheWaitBit);
+	TEST_RUN(InvalidChainsAreRejected);
+	TEST_RUN(VibrateUsesContinuousModeWithoutBank);
+	TEST_RUN(VibrateLoopsBankWaveform);
+	TEST_RUN(VibrateWhileLoopingOnlyChangesGain);
+
+	return TestFailures != 0;
+}
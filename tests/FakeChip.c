@@ -0,0 +1,272 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	FakeChip.c
+
+Abstract:
+
+	AW8624 register file and waveform SRAM standing in for the I2C
+	target.
+
+--*/
+
+#include "FakeChip.h"
+
+// Fast mode I2C, 9 clocks per byte
+#define FAKE_CHIP_BUS_CLOCK_HZ		400000
+#define FAKE_CHIP_BUS_BYTE_CLOCKS	9
+
+FAKE_CHIP FakeChip;
+
+VOID
+FakeChipReset(
+	VOID
+)
+{
+	RtlZeroMemory(&FakeChip, sizeof(FakeChip));
+}
+
+VOID
+FakeChipClearLog(
+	VOID
+)
+{
+	FakeChip.Reads = 0;
+	FakeChip.Writes = 0;
+	FakeChip.Oversized = 0;
+	FakeChip.LogCount = 0;
+}
+
+VOID
+FakeChipPowerCycle(
+	VOID
+)
+{
+	RtlZeroMemory(FakeChip.Registers, sizeof(FakeChip.Registers));
+	RtlZeroMemory(FakeChip.Sram, sizeof(FakeChip.Sram));
+}
+
+ULONG
+FakeChipWritesTo(
+	UCHAR Address
+)
+{
+	PFAKE_CHIP_TRANSFER Transfer = NULL;
+	ULONG Count = 0;
+	ULONG i = 0;
+
+	for (i = 0; i < FakeChip.LogCount; i++)
+	{
+		Transfer = &FakeChip.Log[i];
+
+		if (Transfer->Write &&
+			Address >= Transfer->Address &&
+			Address < Transfer->Address + Transfer->Length)
+		{
+			Count++;
+		}
+	}
+
+	return Count;
+}
+
+ULONG
+FakeChipBusMicroseconds(
+	VOID
+)
+{
+	ULONGLONG Bytes = 0;
+	ULONG i = 0;
+
+	//
+	// Every transfer carries the device and register addresses,
+	// a read adds a repeated start with the device address again
+	//
+	for (i = 0; i < FakeChip.LogCount; i++)
+	{
+		Bytes += 2 + FakeChip.Log[i].Length + (FakeChip.Log[i].Write ? 0 : 1);
+	}
+
+	return (ULONG)(Bytes * FAKE_CHIP_BUS_BYTE_CLOCKS * 1000000 / FAKE_CHIP_BUS_CLOCK_HZ);
+}
+
+static BOOLEAN
+FakeChipIsDataPort(
+	UCHAR Address
+)
+{
+	return Address == AW8624_REG_RTP_DATA || Address == AW8624_REG_RAMDATA;
+}
+
+static VOID
+FakeChipLog(
+	BOOLEAN Write,
+	UCHAR Address,
+	PUCHAR Data,
+	ULONG Length
+)
+{
+	PFAKE_CHIP_TRANSFER Transfer = NULL;
+
+	if (FakeChip.LogCount == FAKE_CHIP_LOG_SIZE)
+	{
+		return;
+	}
+
+	Transfer = &FakeChip.Log[FakeChip.LogCount++];
+	Transfer->Write = Write;
+	Transfer->Address = Address;
+	Transfer->Length = Length;
+	RtlCopyMemory(Transfer->Data, Data, min(Length, FAKE_CHIP_LOG_DATA_SIZE));
+}
+
+//
+// The SRAM byte RAMDATA reaches, advancing RAMADDR past it
+//
+static PUCHAR
+FakeChipRamData(
+	VOID
+)
+{
+	ULONG RamAddress = (FakeChip.Registers[AW8624_REG_RAMADDRH] << 8) | FakeChip.Registers[AW8624_REG_RAMADDRL];
+	PUCHAR Data = &FakeChip.Sram[RamAddress % FAKE_CHIP_SRAM_SIZE];
+
+	RamAddress++;
+	FakeChip.Registers[AW8624_REG_RAMADDRH] = (UCHAR)(RamAddress >> 8);
+	FakeChip.Registers[AW8624_REG_RAMADDRL] = (UCHAR)(RamAddress & 0xFF);
+
+	return Data;
+}
+
+static VOID
+FakeChipStore(
+	UCHAR Address,
+	ULONG Offset,
+	UCHAR Data
+)
+{
+	ULONG Target = FakeChipIsDataPort(Address) ? Address : Address + Offset;
+
+	if (Address == AW8624_REG_RAMDATA)
+	{
+		*FakeChipRamData() = Data;
+		return;
+	}
+
+	if (Target < AW8624_REGISTER_COUNT)
+	{
+		FakeChip.Registers[Target] = Data;
+	}
+}
+
+NTSTATUS
+SpbReadDataSynchronously(
+	IN SPB_CONTEXT* SpbContext,
+	IN UCHAR Address,
+	_In_reads_bytes_(Length) PVOID Data,
+	IN ULONG Length
+)
+{
+	PUCHAR Buffer = (PUCHAR)Data;
+	ULONG i = 0;
+
+	UNREFERENCED_PARAMETER(SpbContext);
+
+	if (FakeChip.ReadHook != NULL)
+	{
+		FakeChip.ReadHook(Address, Length);
+	}
+
+	for (i = 0; i < Length; i++)
+	{
+		if (Address == AW8624_REG_RAMDATA)
+		{
+			Buffer[i] = *FakeChipRamData();
+			continue;
+		}
+
+		Buffer[i] = Address + i < AW8624_REGISTER_COUNT ? FakeChip.Registers[Address + i] : 0;
+
+		// Reading SYSINT acknowledges the flags
+		if (Address + i == AW8624_REG_SYSINT)
+		{
+			FakeChip.Registers[AW8624_REG_SYSINT] = 0;
+		}
+	}
+
+	if (Length > DEFAULT_SPB_BUFFER_SIZE)
+	{
+		FakeChip.Oversized++;
+	}
+
+	FakeChip.Reads++;
+	FakeChipLog(FALSE, Address, Buffer, Length);
+
+	return STATUS_SUCCESS;
+}
+
+NTSTATUS
+SpbWriteDataSynchronously(
+	IN SPB_CONTEXT* SpbContext,
+	IN UCHAR Address,
+	IN PVOID Data,
+	IN ULONG Length
+)
+{
+	PUCHAR Buffer = (PUCHAR)Data;
+	ULONG i = 0;
+
+	UNREFERENCED_PARAMETER(SpbContext);
+
+	for (i = 0; i < Length; i++)
+	{
+		FakeChipStore(Address, i, Buffer[i]);
+	}
+
+	// The address byte shares the buffer with the payload
+	if (Length + 1 > DEFAULT_SPB_BUFFER_SIZE)
+	{
+		FakeChip.Oversized++;
+	}
+
+	FakeChip.Writes++;
+	FakeChipLog(TRUE, Address, Buffer, Length);
+
+	return STATUS_SUCCESS;
+}
+
+NTSTATUS
+SpbWriteDataGathered(
+	IN SPB_CONTEXT* SpbContext,
+	IN UCHAR Address,
+	IN PSPB_WRITE_SEGMENT Segments,
+	IN ULONG SegmentCount
+)
+{
+	UCHAR Logged[FAKE_CHIP_LOG_DATA_SIZE];
+	ULONG Offset = 0;
+	ULONG i = 0;
+	ULONG j = 0;
+
+	UNREFERENCED_PARAMETER(SpbContext);
+
+	for (i = 0; i < SegmentCount; i++)
+	{
+		for (j = 0; j < Segments[i].Length; j++, Offset++)
+		{
+			FakeChipStore(Address, Offset, ((PUCHAR)Segments[i].Buffer)[j]);
+
+			if (Offset < sizeof(Logged))
+			{
+				Logged[Offset] = ((PUCHAR)Segments[i].Buffer)[j];
+			}
+		}
+	}
+
+	FakeChip.Writes++;
+	FakeChipLog(TRUE, Address, Logged, Offset);
+
+	return STATUS_SUCCESS;
+}
@@ -0,0 +1,95 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	FakeChip.h
+
+Abstract:
+
+	AW8624 register file behind the driver's SPB helpers. Every transfer
+	is counted and logged so tests can check what reached the bus.
+
+--*/
+
+#pragma once
+
+#include "Driver.h"
+
+#define FAKE_CHIP_LOG_SIZE		256
+#define FAKE_CHIP_LOG_DATA_SIZE	32
+
+#define FAKE_CHIP_SRAM_SIZE		(8 * 1024)
+
+typedef struct _FAKE_CHIP_TRANSFER
+{
+	BOOLEAN Write;
+	UCHAR Address;
+	ULONG Length;
+	UCHAR Data[FAKE_CHIP_LOG_DATA_SIZE];
+} FAKE_CHIP_TRANSFER, * PFAKE_CHIP_TRANSFER;
+
+//
+// Called before a read is served, so a test can model registers
+// the chip computes, such as measurement results
+//
+typedef VOID FAKE_CHIP_READ_HOOK(UCHAR Address, ULONG Length);
+
+typedef struct _FAKE_CHIP
+{
+	UCHAR Registers[AW8624_REGISTER_COUNT];
+
+	// Waveform memory behind RAMDATA, at the address RAMADDR points to
+	UCHAR Sram[FAKE_CHIP_SRAM_SIZE];
+
+	ULONG Reads;
+	ULONG Writes;
+
+	// Transfers too long for Spb.c's default buffers, each an allocation there
+	ULONG Oversized;
+
+	FAKE_CHIP_TRANSFER Log[FAKE_CHIP_LOG_SIZE];
+	ULONG LogCount;
+
+	FAKE_CHIP_READ_HOOK* ReadHook;
+} FAKE_CHIP, * PFAKE_CHIP;
+
+extern FAKE_CHIP FakeChip;
+
+VOID
+FakeChipReset(
+	VOID
+);
+
+//
+// Forgets the transfers issued so far, the register contents stay
+//
+VOID
+FakeChipClearLog(
+	VOID
+);
+
+//
+// Drops the rail, every register and the SRAM return to zero.
+// Counters and the log are kept.
+//
+VOID
+FakeChipPowerCycle(
+	VOID
+);
+
+//
+// Number of logged writes whose span covers Address
+//
+ULONG
+FakeChipWritesTo(
+	UCHAR Address
+);
+
+//
+// Time the logged transfers occupy a 400 kHz bus, in microseconds
+//
+ULONG
+FakeChipBusMicroseconds(
+	VOID
+);
@@ -0,0 +1,415 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	Harness.c
+
+Abstract:
+
+	Host implementations of the kernel and KMDF routines the driver
+	core calls. Everything runs on the test's thread, so locks are
+	no-ops and nothing is ever waited on.
+
+--*/
+
+#include "Harness.h"
+
+ULONG TestFailures;
+ULONG HarnessWorkItemsQueued;
+LONGLONG HarnessTimerDueTime;
+VOID (*HarnessWaitHook)(VOID);
+LONGLONG HarnessWaitTimeout;
+
+static PDEVICE_CONTEXT HarnessDevice;
+
+VOID
+HarnessInitializeDevice(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	RtlZeroMemory(pDevice, sizeof(*pDevice));
+	pDevice->Device = (WDFDEVICE)pDevice;
+
+	HarnessDevice = pDevice;
+	HarnessWorkItemsQueued = 0;
+	HarnessTimerDueTime = 0;
+	HarnessWaitHook = NULL;
+	HarnessWaitTimeout = 0;
+
+	FakeChipReset();
+}
+
+PDEVICE_CONTEXT
+DeviceGetContext(
+	WDFOBJECT Handle
+)
+{
+	return (PDEVICE_CONTEXT)Handle;
+}
+
+PVOID
+ExAllocatePool2(
+	ULONGLONG Flags,
+	SIZE_T NumberOfBytes,
+	ULONG Tag
+)
+{
+	UNREFERENCED_PARAMETER(Flags);
+	UNREFERENCED_PARAMETER(Tag);
+
+	return calloc(1, NumberOfBytes);
+}
+
+VOID
+ExFreePoolWithTag(
+	PVOID P,
+	ULONG Tag
+)
+{
+	UNREFERENCED_PARAMETER(Tag);
+
+	free(P);
+}
+
+VOID
+KeInitializeEvent(
+	PKEVENT Event,
+	EVENT_TYPE Type,
+	BOOLEAN State
+)
+{
+	UNREFERENCED_PARAMETER(Type);
+
+	Event->Signaled = State;
+}
+
+LONG
+KeSetEvent(
+	PKEVENT Event,
+	LONG Increment,
+	BOOLEAN Wait
+)
+{
+	LONG Previous = Event->Signaled;
+
+	UNREFERENCED_PARAMETER(Increment);
+	UNREFERENCED_PARAMETER(Wait);
+
+	Event->Signaled = TRUE;
+
+	return Previous;
+}
+
+VOID
+KeClearEvent(
+	PKEVENT Event
+)
+{
+	Event->Signaled = FALSE;
+}
+
+NTSTATUS
+KeWaitForSingleObject(
+	PVOID Object,
+	KWAIT_REASON WaitReason,
+	KPROCESSOR_MODE WaitMode,
+	BOOLEAN Alertable,
+	PLARGE_INTEGER Timeout
+)
+{
+	UNREFERENCED_PARAMETER(WaitReason);
+	UNREFERENCED_PARAMETER(WaitMode);
+	UNREFERENCED_PARAMETER(Alertable);
+
+	HarnessWaitTimeout = Timeout != NULL ? Timeout->QuadPart : 0;
+
+	if (HarnessWaitHook != NULL)
+	{
+		HarnessWaitHook();
+	}
+
+	// Nothing else runs, so an unsignalled event times out at once
+	return ((PKEVENT)Object)->Signaled ? STATUS_SUCCESS : STATUS_TIMEOUT;
+}
+
+NTSTATUS
+KeDelayExecutionThread(
+	KPROCESSOR_MODE WaitMode,
+	BOOLEAN Alertable,
+	PLARGE_INTEGER Interval
+)
+{
+	UNREFERENCED_PARAMETER(WaitMode);
+	UNREFERENCED_PARAMETER(Alertable);
+	UNREFERENCED_PARAMETER(Interval);
+
+	return STATUS_SUCCESS;
+}
+
+LONG
+InterlockedIncrement(
+	volatile LONG* Addend
+)
+{
+	return ++(*Addend);
+}
+
+LONG
+InterlockedExchange(
+	volatile LONG* Target,
+	LONG Value
+)
+{
+	LONG Previous = *Target;
+
+	*Target = Value;
+
+	return Previous;
+}
+
+NTSTATUS
+WdfWaitLockAcquire(
+	WDFWAITLOCK Lock,
+	PLONGLONG Timeout
+)
+{
+	UNREFERENCED_PARAMETER(Lock);
+	UNREFERENCED_PARAMETER(Timeout);
+
+	return STATUS_SUCCESS;
+}
+
+VOID
+WdfWaitLockRelease(
+	WDFWAITLOCK Lock
+)
+{
+	UNREFERENCED_PARAMETER(Lock);
+}
+
+VOID
+WdfWorkItemEnqueue(
+	WDFWORKITEM WorkItem
+)
+{
+	UNREFERENCED_PARAMETER(WorkItem);
+
+	HarnessWorkItemsQueued++;
+}
+
+WDFOBJECT
+WdfWorkItemGetParentObject(
+	WDFWORKITEM WorkItem
+)
+{
+	UNREFERENCED_PARAMETER(WorkItem);
+
+	return (WDFOBJECT)HarnessDevice;
+}
+
+BOOLEAN
+WdfTimerStart(
+	WDFTIMER Timer,
+	LONGLONG DueTime
+)
+{
+	BOOLEAN Queued = HarnessTimerDueTime != 0;
+
+	UNREFERENCED_PARAMETER(Timer);
+
+	HarnessTimerDueTime = DueTime;
+
+	return Queued;
+}
+
+BOOLEAN
+WdfTimerStop(
+	WDFTIMER Timer,
+	BOOLEAN Wait
+)
+{
+	BOOLEAN Queued = HarnessTimerDueTime != 0;
+
+	UNREFERENCED_PARAMETER(Timer);
+	UNREFERENCED_PARAMETER(Wait);
+
+	HarnessTimerDueTime = 0;
+
+	return Queued;
+}
+
+WDFOBJECT
+WdfTimerGetParentObject(
+	WDFTIMER Timer
+)
+{
+	UNREFERENCED_PARAMETER(Timer);
+
+	return (WDFOBJECT)HarnessDevice;
+}
+
+//
+// The hardware key is empty, so profile and calibration
+// fall back to their defaults
+//
+NTSTATUS
+WdfDeviceOpenRegistryKey(
+	WDFDEVICE Device,
+	ULONG DeviceInstanceKeyType,
+	ACCESS_MASK DesiredAccess,
+	PWDF_OBJECT_ATTRIBUTES KeyAttributes,
+	WDFKEY* Key
+)
+{
+	UNREFERENCED_PARAMETER(Device);
+	UNREFERENCED_PARAMETER(DeviceInstanceKeyType);
+	UNREFERENCED_PARAMETER(DesiredAccess);
+	UNREFERENCED_PARAMETER(KeyAttributes);
+
+	*Key = NULL;
+
+	return STATUS_OBJECT_NAME_NOT_FOUND;
+}
+
+NTSTATUS
+WdfRegistryQueryValue(
+	WDFKEY Key,
+	PUNICODE_STRING ValueName,
+	ULONG ValueLength,
+	PVOID Value,
+	PULONG ValueLengthQueried,
+	PULONG ValueType
+)
+{
+	UNREFERENCED_PARAMETER(Key);
+	UNREFERENCED_PARAMETER(ValueName);
+	UNREFERENCED_PARAMETER(ValueLength);
+	UNREFERENCED_PARAMETER(Value);
+	UNREFERENCED_PARAMETER(ValueLengthQueried);
+	UNREFERENCED_PARAMETER(ValueType);
+
+	return STATUS_OBJECT_NAME_NOT_FOUND;
+}
+
+NTSTATUS
+WdfRegistryQueryULong(
+	WDFKEY Key,
+	PUNICODE_STRING ValueName,
+	PULONG Value
+)
+{
+	UNREFERENCED_PARAMETER(Key);
+	UNREFERENCED_PARAMETER(ValueName);
+	UNREFERENCED_PARAMETER(Value);
+
+	return STATUS_OBJECT_NAME_NOT_FOUND;
+}
+
+NTSTATUS
+WdfRegistryAssignULong(
+	WDFKEY Key,
+	PUNICODE_STRING ValueName,
+	ULONG Value
+)
+{
+	UNREFERENCED_PARAMETER(Key);
+	UNREFERENCED_PARAMETER(ValueName);
+	UNREFERENCED_PARAMETER(Value);
+
+	return STATUS_SUCCESS;
+}
+
+VOID
+WdfRegistryClose(
+	WDFKEY Key
+)
+{
+	UNREFERENCED_PARAMETER(Key);
+}
+
+NTSTATUS
+ZwCreateFile(
+	PHANDLE FileHandle,
+	ACCESS_MASK DesiredAccess,
+	POBJECT_ATTRIBUTES ObjectAttributes,
+	PIO_STATUS_BLOCK IoStatusBlock,
+	PLARGE_INTEGER AllocationSize,
+	ULONG FileAttributes,
+	ULONG ShareAccess,
+	ULONG CreateDisposition,
+	ULONG CreateOptions,
+	PVOID EaBuffer,
+	ULONG EaLength
+)
+{
+	UNREFERENCED_PARAMETER(DesiredAccess);
+	UNREFERENCED_PARAMETER(ObjectAttributes);
+	UNREFERENCED_PARAMETER(IoStatusBlock);
+	UNREFERENCED_PARAMETER(AllocationSize);
+	UNREFERENCED_PARAMETER(FileAttributes);
+	UNREFERENCED_PARAMETER(ShareAccess);
+	UNREFERENCED_PARAMETER(CreateDisposition);
+	UNREFERENCED_PARAMETER(CreateOptions);
+	UNREFERENCED_PARAMETER(EaBuffer);
+	UNREFERENCED_PARAMETER(EaLength);
+
+	// No waveform bank is installed on the host
+	*FileHandle = NULL;
+
+	return STATUS_OBJECT_NAME_NOT_FOUND;
+}
+
+NTSTATUS
+ZwReadFile(
+	HANDLE FileHandle,
+	HANDLE Event,
+	PVOID ApcRoutine,
+	PVOID ApcContext,
+	PIO_STATUS_BLOCK IoStatusBlock,
+	PVOID Buffer,
+	ULONG Length,
+	PLARGE_INTEGER ByteOffset,
+	PULONG Key
+)
+{
+	UNREFERENCED_PARAMETER(FileHandle);
+	UNREFERENCED_PARAMETER(Event);
+	UNREFERENCED_PARAMETER(ApcRoutine);
+	UNREFERENCED_PARAMETER(ApcContext);
+	UNREFERENCED_PARAMETER(IoStatusBlock);
+	UNREFERENCED_PARAMETER(Buffer);
+	UNREFERENCED_PARAMETER(Length);
+	UNREFERENCED_PARAMETER(ByteOffset);
+	UNREFERENCED_PARAMETER(Key);
+
+	return STATUS_UNSUCCESSFUL;
+}
+
+NTSTATUS
+ZwQueryInformationFile(
+	HANDLE FileHandle,
+	PIO_STATUS_BLOCK IoStatusBlock,
+	PVOID FileInformation,
+	ULONG Length,
+	FILE_INFORMATION_CLASS FileInformationClass
+)
+{
+	UNREFERENCED_PARAMETER(FileHandle);
+	UNREFERENCED_PARAMETER(IoStatusBlock);
+	UNREFERENCED_PARAMETER(FileInformation);
+	UNREFERENCED_PARAMETER(Length);
+	UNREFERENCED_PARAMETER(FileInformationClass);
+
+	return STATUS_UNSUCCESSFUL;
+}
+
+NTSTATUS
+ZwClose(
+	HANDLE Handle
+)
+{
+	UNREFERENCED_PARAMETER(Handle);
+
+	return STATUS_SUCCESS;
+}
@@ -0,0 +1,81 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	Harness.h
+
+Abstract:
+
+	Host implementations of the kernel and KMDF routines the driver
+	core calls, and the checks the unit tests report through.
+
+--*/
+
+#pragma once
+
+#include <stdio.h>
+#include "Driver.h"
+#include "FakeChip.h"
+
+extern ULONG TestFailures;
+
+//
+// Work items queued through WdfWorkItemEnqueue, they never run on
+// their own. Tests call the callbacks directly where that matters.
+//
+extern ULONG HarnessWorkItemsQueued;
+
+//
+// The timer never fires on its own either. HarnessTimerDueTime holds
+// the relative due time of the last WdfTimerStart, in 100 ns units,
+// and is 0 while the timer is stopped or has fired.
+//
+extern LONGLONG HarnessTimerDueTime;
+
+//
+// Called by KeWaitForSingleObject before it looks at the event, in
+// place of whatever would signal it meanwhile, such as the DONE
+// interrupt. HarnessWaitTimeout holds the timeout of the last wait.
+//
+extern VOID (*HarnessWaitHook)(VOID);
+extern LONGLONG HarnessWaitTimeout;
+
+#define TEST_CHECK(Condition)											\
+	do																	\
+	{																	\
+		if (!(Condition))												\
+		{																\
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #Condition);	\
+			TestFailures++;												\
+		}																\
+	} while (0)
+
+#define TEST_CHECK_EQUAL(Expected, Actual)								\
+	do																	\
+	{																	\
+		long long _Expected = (long long)(Expected);					\
+		long long _Actual = (long long)(Actual);						\
+		if (_Expected != _Actual)										\
+		{																\
+			printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #Actual, _Actual, _Expected);	\
+			TestFailures++;												\
+		}																\
+	} while (0)
+
+#define TEST_RUN(Test)													\
+	do																	\
+	{																	\
+		ULONG _Failures = TestFailures;									\
+		Test();															\
+		printf("%s %s\n", TestFailures == _Failures ? "PASS" : "FAIL", #Test);	\
+	} while (0)
+
+//
+// Zeroes the device context and the fake chip, and makes pDevice the
+// parent every work item and timer resolves to
+//
+VOID
+HarnessInitializeDevice(
+	PDEVICE_CONTEXT pDevice
+);
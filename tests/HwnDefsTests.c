@@ -0,0 +1,420 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	HwnDefsTests.c
+
+Abstract:
+
+	The per-device HwN state store, HwN id validation, collapsing of
+	queued requests that have not run yet, the sequences a multi-entry
+	buffer runs, what the caller waits for, and a 1 kHz toggle trace
+	replayed against the bus time each sequence takes.
+
+--*/
+
+#include "aw8624.c"
+#include "HwnDefs.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+// A 1 kHz on/off toggle, and how long the motor brakes before DONE
+#define TOGGLE_TRACE_LENGTH				1000
+#define TOGGLE_INTERVAL_MICROSECONDS	1000
+#define BRAKE_MICROSECONDS				5000
+
+static ULONG Completions;
+static ULONG DoneWaits;
+static HWN_SETTINGS Completed[AW8624_MAX_HWN_DEVICES];
+
+static VOID
+CountCompletion(
+	PDEVICE_CONTEXT devContext,
+	PHWN_SETTINGS hwnSettings,
+	NTSTATUS Status
+)
+{
+	UNREFERENCED_PARAMETER(devContext);
+
+	if (NT_SUCCESS(Status) && Completions < ARRAYSIZE(Completed))
+	{
+		Completed[Completions] = *hwnSettings;
+	}
+
+	Completions++;
+}
+
+// The chip finishes braking as soon as a stop waits for it
+static VOID
+SignalDone(
+	VOID
+)
+{
+	DoneWaits++;
+	KeSetEvent(&Device.PlaybackDoneEvent, IO_NO_INCREMENT, FALSE);
+}
+
+static VOID
+PrepareDevice(
+	USHORT NumberOfHapticsDevices
+)
+{
+	HarnessInitializeDevice(&Device);
+	KeInitializeEvent(&Device.PlaybackDoneEvent, NotificationEvent, FALSE);
+
+	Device.Profile = AW8624DefaultProfile;
+	AW8624BuildProfileImage(&Device);
+	AW8624BuildDriveLevels(&Device);
+
+	Device.NumberOfHapticsDevices = NumberOfHapticsDevices;
+	Device.RequestQueue.WorkItem = (WDFWORKITEM)&Device.RequestQueue;
+
+	HarnessWaitHook = SignalDone;
+
+	Completions = 0;
+}
+
+static VOID
+SettingsFor(
+	PHWN_SETTINGS hwnSettings,
+	ULONG HwNId,
+	HWN_STATE State,
+	ULONG Intensity
+)
+{
+	RtlZeroMemory(hwnSettings, sizeof(*hwnSettings));
+
+	hwnSettings->HwNId = HwNId;
+	hwnSettings->HwNType = HWN_VIBRATOR;
+	hwnSettings->OffOnBlink = State;
+	hwnSettings->HwNSettings[HWN_INTENSITY] = Intensity;
+}
+
+static VOID
+StatesStartOffPerDevice(
+	VOID
+)
+{
+	HWN_SETTINGS Settings;
+	ULONG i = 0;
+
+	PrepareDevice(3);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsInitializeDeviceState(&Device));
+
+	for (i = 0; i < 3; i++)
+	{
+		RtlZeroMemory(&Settings, sizeof(Settings));
+		Settings.HwNId = i;
+
+		TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsGetCurrentDeviceState(&Device, &Settings, sizeof(Settings)));
+		TEST_CHECK_EQUAL(i, Settings.HwNId);
+		TEST_CHECK_EQUAL(HWN_VIBRATOR, Settings.HwNType);
+		TEST_CHECK_EQUAL(HWN_OFF, Settings.OffOnBlink);
+		TEST_CHECK_EQUAL(0, Settings.HwNSettings[HWN_INTENSITY]);
+		TEST_CHECK_EQUAL(HWN_CURRENT_MTE_NOT_SUPPORTED, Settings.HwNSettings[HWN_CURRENT_MTE_RESERVED]);
+	}
+
+	ExFreePoolWithTag(Device.CurrentStates, HAPTICS_POOL_TAG);
+}
+
+static VOID
+SetStateIsReadBackById(
+	VOID
+)
+{
+	HWN_SETTINGS Settings;
+
+	PrepareDevice(3);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsInitializeDeviceState(&Device));
+
+	SettingsFor(&Settings, 1, HWN_ON, 70);
+	Settings.HwNSettings[HWN_CYCLE_GRANULARITY] = 5;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsSetCurrentDeviceState(&Device, &Settings, sizeof(Settings)));
+
+	// The driver does not report granularity or current
+	TEST_CHECK_EQUAL(0, Device.CurrentStates[1].HwNSettings[HWN_CYCLE_GRANULARITY]);
+	TEST_CHECK_EQUAL(HWN_CURRENT_MTE_NOT_SUPPORTED, Device.CurrentStates[1].HwNSettings[HWN_CURRENT_MTE_RESERVED]);
+
+	RtlZeroMemory(&Settings, sizeof(Settings));
+	Settings.HwNId = 1;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsGetCurrentDeviceState(&Device, &Settings, sizeof(Settings)));
+	TEST_CHECK_EQUAL(HWN_ON, Settings.OffOnBlink);
+	TEST_CHECK_EQUAL(70, Settings.HwNSettings[HWN_INTENSITY]);
+
+	// Neighbouring entries are untouched
+	TEST_CHECK_EQUAL(HWN_OFF, Device.CurrentStates[0].OffOnBlink);
+	TEST_CHECK_EQUAL(HWN_OFF, Device.CurrentStates[2].OffOnBlink);
+
+	ExFreePoolWithTag(Device.CurrentStates, HAPTICS_POOL_TAG);
+}
+
+static VOID
+OutOfRangeIdsAreRejected(
+	VOID
+)
+{
+	HWN_SETTINGS Settings[2];
+
+	PrepareDevice(2);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsInitializeDeviceState(&Device));
+
+	SettingsFor(&Settings[0], 0, HWN_ON, 50);
+	SettingsFor(&Settings[1], 2, HWN_ON, 50);
+
+	TEST_CHECK_EQUAL(STATUS_INVALID_PARAMETER, AW8624HapticsGetCurrentDeviceState(&Device, &Settings[1], sizeof(Settings[1])));
+	TEST_CHECK_EQUAL(STATUS_INVALID_PARAMETER, AW8624HapticsSetCurrentDeviceState(&Device, &Settings[1], sizeof(Settings[1])));
+	TEST_CHECK_EQUAL(STATUS_INVALID_PARAMETER, AW8624HapticsSetDevice(&Device, &Settings[1]));
+	TEST_CHECK_EQUAL(0, FakeChip.Reads + FakeChip.Writes);
+
+	// One bad entry rejects the whole buffer before anything is queued
+	TEST_CHECK_EQUAL(STATUS_INVALID_PARAMETER, AW8624HapticsQueueSetDevices(&Device, Settings, 2, CountCompletion));
+	TEST_CHECK_EQUAL(0, Device.RequestQueue.Accepted);
+	TEST_CHECK_EQUAL(0, Device.RequestQueue.PendingCount);
+	TEST_CHECK(!Device.RequestQueue.Requests[0].Pending);
+	TEST_CHECK_EQUAL(0, HarnessWorkItemsQueued);
+
+	// Ids the device reports but the queue has no slot for
+	Device.NumberOfHapticsDevices = AW8624_MAX_HWN_DEVICES + 1;
+	SettingsFor(&Settings[1], AW8624_MAX_HWN_DEVICES, HWN_ON, 50);
+
+	TEST_CHECK_EQUAL(STATUS_INVALID_PARAMETER, AW8624HapticsQueueSetDevices(&Device, &Settings[1], 1, CountCompletion));
+	TEST_CHECK_EQUAL(0, HarnessWorkItemsQueued);
+
+	ExFreePoolWithTag(Device.CurrentStates, HAPTICS_POOL_TAG);
+}
+
+static VOID
+PendingRequestsCollapsePerDevice(
+	VOID
+)
+{
+	HWN_SETTINGS Settings[4];
+
+	PrepareDevice(2);
+
+	SettingsFor(&Settings[0], 0, HWN_ON, 40);
+	SettingsFor(&Settings[1], 1, HWN_ON, 60);
+	SettingsFor(&Settings[2], 0, HWN_ON, 80);
+	SettingsFor(&Settings[3], 0, HWN_OFF, 0);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsQueueSetDevices(&Device, Settings, 3, CountCompletion));
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsQueueSetDevices(&Device, &Settings[3], 1, CountCompletion));
+
+	TEST_CHECK_EQUAL(4, Device.RequestQueue.Accepted);
+	TEST_CHECK_EQUAL(2, Device.RequestQueue.Collapsed);
+	TEST_CHECK_EQUAL(2, Device.RequestQueue.PendingCount);
+	TEST_CHECK_EQUAL(2, HarnessWorkItemsQueued);
+
+	// Last writer wins
+	TEST_CHECK_EQUAL(HWN_OFF, Device.RequestQueue.Requests[0].Settings.OffOnBlink);
+	TEST_CHECK_EQUAL(60, Device.RequestQueue.Requests[1].Settings.HwNSettings[HWN_INTENSITY]);
+
+	// Both slots drain in one batch, in HwN id order
+	AW8624HapticsRequestWorkItem(Device.RequestQueue.WorkItem);
+
+	TEST_CHECK_EQUAL(1, Device.RequestQueue.Batches);
+	TEST_CHECK_EQUAL(2, Device.RequestQueue.Executed);
+	TEST_CHECK_EQUAL(0, Device.RequestQueue.PendingCount);
+	TEST_CHECK_EQUAL(2, Completions);
+	TEST_CHECK_EQUAL(0, Completed[0].HwNId);
+	TEST_CHECK_EQUAL(HWN_OFF, Completed[0].OffOnBlink);
+	TEST_CHECK_EQUAL(1, Completed[1].HwNId);
+	TEST_CHECK_EQUAL(HWN_ON, Completed[1].OffOnBlink);
+
+	// Drained slots are free, a new request is not counted as collapsed
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsQueueSetDevices(&Device, &Settings[0], 1, CountCompletion));
+	TEST_CHECK_EQUAL(2, Device.RequestQueue.Collapsed);
+	TEST_CHECK_EQUAL(1, Device.RequestQueue.PendingCount);
+}
+
+static VOID
+BufferRunsOneSequencePerEntry(
+	VOID
+)
+{
+	HWN_SETTINGS Settings[3];
+
+	PrepareDevice(3);
+
+	// Every entry changes what the motor does, so each needs its own sequence
+	SettingsFor(&Settings[0], 0, HWN_ON, 40);
+	SettingsFor(&Settings[1], 1, HWN_OFF, 0);
+	SettingsFor(&Settings[2], 2, HWN_ON, 80);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsQueueSetDevices(&Device, Settings, 3, CountCompletion));
+	TEST_CHECK_EQUAL(1, HarnessWorkItemsQueued);
+
+	AW8624HapticsRequestWorkItem(Device.RequestQueue.WorkItem);
+
+	// One start, one stop, one start, rather than every entry on every device
+	TEST_CHECK_EQUAL(3, FakeChipWritesTo(AW8624_REG_GO));
+	TEST_CHECK_EQUAL(AW8624_BIT_GO_ENABLE, FakeChip.Registers[AW8624_REG_GO]);
+	TEST_CHECK_EQUAL(80, Device.PreviousIntensity);
+	TEST_CHECK_EQUAL(0, Device.StopTimeouts);
+
+	TEST_CHECK_EQUAL(1, Device.RequestQueue.Batches);
+	TEST_CHECK_EQUAL(3, Device.RequestQueue.Executed);
+	TEST_CHECK_EQUAL(3, Completions);
+}
+
+static VOID
+RepeatedEntriesRunOnce(
+	VOID
+)
+{
+	HWN_SETTINGS Settings[6];
+	ULONG i = 0;
+
+	PrepareDevice(2);
+
+	for (i = 0; i < ARRAYSIZE(Settings); i++)
+	{
+		SettingsFor(&Settings[i], i % 2, HWN_ON, 10 * (i + 1));
+	}
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsQueueSetDevices(&Device, Settings, ARRAYSIZE(Settings), CountCompletion));
+	TEST_CHECK_EQUAL(4, Device.RequestQueue.Collapsed);
+
+	AW8624HapticsRequestWorkItem(Device.RequestQueue.WorkItem);
+
+	// Only the last entry for each device runs
+	TEST_CHECK_EQUAL(2, Device.RequestQueue.Executed);
+	TEST_CHECK_EQUAL(2, Completions);
+	TEST_CHECK_EQUAL(50, Completed[0].HwNSettings[HWN_INTENSITY]);
+	TEST_CHECK_EQUAL(60, Completed[1].HwNSettings[HWN_INTENSITY]);
+	TEST_CHECK_EQUAL(60, Device.PreviousIntensity);
+
+	// The same buffer again changes nothing and never reaches the bus
+	FakeChipClearLog();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsQueueSetDevices(&Device, &Settings[5], 1, CountCompletion));
+	AW8624HapticsRequestWorkItem(Device.RequestQueue.WorkItem);
+
+	TEST_CHECK_EQUAL(1, Device.SkippedStarts);
+	TEST_CHECK_EQUAL(0, FakeChip.Writes);
+}
+
+static VOID
+CallerNeverWaitsForTheBus(
+	VOID
+)
+{
+	HWN_SETTINGS Settings[2];
+	ULONG CallerTransfers = 0;
+	ULONG CallerMicroseconds = 0;
+	ULONG SequenceTransfers = 0;
+	ULONG SequenceMicroseconds = 0;
+
+	PrepareDevice(2);
+
+	SettingsFor(&Settings[0], 0, HWN_ON, 100);
+	SettingsFor(&Settings[1], 1, HWN_ON, 60);
+
+	// All the caller of AW8624HapticsSetState waits for
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsQueueSetDevices(&Device, Settings, 2, CountCompletion));
+
+	CallerTransfers = FakeChip.Reads + FakeChip.Writes;
+	CallerMicroseconds = FakeChipBusMicroseconds();
+
+	TEST_CHECK_EQUAL(0, CallerTransfers);
+	TEST_CHECK_EQUAL(0, Completions);
+
+	// What the worker does afterwards
+	FakeChipClearLog();
+	AW8624HapticsRequestWorkItem(Device.RequestQueue.WorkItem);
+
+	SequenceTransfers = FakeChip.Reads + FakeChip.Writes;
+	SequenceMicroseconds = FakeChipBusMicroseconds();
+
+	TEST_CHECK(SequenceTransfers > 0);
+	TEST_CHECK_EQUAL(2, Completions);
+
+	printf(
+		"Set-state: caller %u transfers, %u us; sequence %u transfers, %u us\n",
+		CallerTransfers,
+		CallerMicroseconds,
+		SequenceTransfers,
+		SequenceMicroseconds);
+}
+
+static VOID
+ToggleTraceCollapses(
+	VOID
+)
+{
+	HWN_SETTINGS Settings;
+	ULONGLONG WorkerFreeAt = 0;
+	ULONG Next = 0;
+	ULONG Batches = 0;
+
+	PrepareDevice(1);
+
+	while (Next < TOGGLE_TRACE_LENGTH)
+	{
+		// Everything that arrived while the worker was busy queues up
+		while (Next < TOGGLE_TRACE_LENGTH &&
+			(ULONGLONG)Next * TOGGLE_INTERVAL_MICROSECONDS <= WorkerFreeAt)
+		{
+			SettingsFor(&Settings, 0, Next % 2 == 0 ? HWN_ON : HWN_OFF, 100);
+			TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsQueueSetDevices(&Device, &Settings, 1, CountCompletion));
+			Next++;
+		}
+
+		if (Device.RequestQueue.PendingCount == 0)
+		{
+			WorkerFreeAt = (ULONGLONG)Next * TOGGLE_INTERVAL_MICROSECONDS;
+			continue;
+		}
+
+		FakeChipClearLog();
+		DoneWaits = 0;
+
+		AW8624HapticsRequestWorkItem(Device.RequestQueue.WorkItem);
+		Batches++;
+
+		WorkerFreeAt += FakeChipBusMicroseconds() + DoneWaits * BRAKE_MICROSECONDS;
+	}
+
+	TEST_CHECK_EQUAL(TOGGLE_TRACE_LENGTH, Device.RequestQueue.Accepted);
+	TEST_CHECK_EQUAL(TOGGLE_TRACE_LENGTH, Device.RequestQueue.Executed + Device.RequestQueue.Collapsed);
+	TEST_CHECK_EQUAL(Batches, Device.RequestQueue.Batches);
+	TEST_CHECK(Device.RequestQueue.Collapsed > Device.RequestQueue.Executed);
+
+	// The backlog never grows, the last request runs one stop after it arrived
+	TEST_CHECK(WorkerFreeAt <= (ULONGLONG)TOGGLE_TRACE_LENGTH * TOGGLE_INTERVAL_MICROSECONDS + 2 * BRAKE_MICROSECONDS);
+
+	// The trace ends on HWN_OFF, and so does the motor
+	TEST_CHECK_EQUAL(HWN_OFF, Device.PreviousState);
+	TEST_CHECK_EQUAL(AW8624_BIT_GO_DISABLE, FakeChip.Registers[AW8624_REG_GO]);
+
+	printf(
+		"1 kHz toggle trace: %u requests, %u executed, %u collapsed, idle after %u us\n",
+		Device.RequestQueue.Accepted,
+		Device.RequestQueue.Executed,
+		Device.RequestQueue.Collapsed,
+		(ULONG)WorkerFreeAt);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(StatesStartOffPerDevice);
+	TEST_RUN(SetStateIsReadBackById);
+	TEST_RUN(OutOfRangeIdsAreRejected);
+	TEST_RUN(PendingRequestsCollapsePerDevice);
+	TEST_RUN(BufferRunsOneSequencePerEntry);
+	TEST_RUN(RepeatedEntriesRunOnce);
+	TEST_RUN(CallerNeverWaitsForTheBus);
+	TEST_RUN(ToggleTraceCollapses);
+
+	return TestFailures != 0;
+}
@@ -0,0 +1,150 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	InterruptTests.c
+
+Abstract:
+
+	The SYSINT dispatch table and what each serviced interrupt does.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+static VOID
+StartPlayback(
+	VOID
+)
+{
+	HarnessInitializeDevice(&Device);
+	KeInitializeEvent(&Device.PlaybackDoneEvent, NotificationEvent, FALSE);
+	Device.PlaybackActive = TRUE;
+}
+
+static VOID
+TableServicesFaultsBeforeDone(
+	VOID
+)
+{
+	static const UINT8 Expected[] =
+	{
+		AW8624_BIT_SYSINT_UVLI,
+		AW8624_BIT_SYSINT_OCDI,
+		AW8624_BIT_SYSINT_OTI,
+		AW8624_BIT_SYSINT_DONEI,
+	};
+	ULONG i = 0;
+
+	TEST_CHECK_EQUAL(ARRAYSIZE(Expected), ARRAYSIZE(AW8624InterruptDispatch));
+
+	for (i = 0; i < min(ARRAYSIZE(Expected), ARRAYSIZE(AW8624InterruptDispatch)); i++)
+	{
+		TEST_CHECK_EQUAL(Expected[i], AW8624InterruptDispatch[i].Bit);
+		TEST_CHECK(AW8624InterruptDispatch[i].Handler != NULL);
+	}
+}
+
+static VOID
+DoneEndsPlaybackWithoutBusTraffic(
+	VOID
+)
+{
+	StartPlayback();
+
+	AW8624DispatchInterrupts(&Device, AW8624_BIT_SYSINT_DONEI);
+
+	TEST_CHECK(!Device.PlaybackActive);
+	TEST_CHECK(Device.PlaybackDoneEvent.Signaled);
+	TEST_CHECK(!Device.RecoveryPending);
+	TEST_CHECK_EQUAL(1, Device.InterruptCounts[0]);
+	TEST_CHECK_EQUAL(0, FakeChip.Reads + FakeChip.Writes);
+}
+
+static VOID
+UnderVoltageRequestsRecovery(
+	VOID
+)
+{
+	StartPlayback();
+
+	AW8624DispatchInterrupts(&Device, AW8624_BIT_SYSINT_UVLI);
+
+	TEST_CHECK(Device.RecoveryPending);
+	TEST_CHECK(!Device.PlaybackActive);
+	TEST_CHECK(Device.PlaybackDoneEvent.Signaled);
+	TEST_CHECK_EQUAL(1, Device.InterruptCounts[5]);
+	TEST_CHECK_EQUAL(0, FakeChip.Writes);
+}
+
+static VOID
+DriverFaultsStopTheMotor(
+	VOID
+)
+{
+	StartPlayback();
+	FakeChip.Registers[AW8624_REG_GO] = AW8624_BIT_GO_ENABLE;
+
+	AW8624DispatchInterrupts(&Device, AW8624_BIT_SYSINT_OCDI | AW8624_BIT_SYSINT_OTI);
+
+	// Each fault handler clears GO, neither requests re-initialization
+	TEST_CHECK_EQUAL(2, FakeChipWritesTo(AW8624_REG_GO));
+	TEST_CHECK_EQUAL(AW8624_BIT_GO_DISABLE, FakeChip.Registers[AW8624_REG_GO]);
+	TEST_CHECK(!Device.PlaybackActive);
+	TEST_CHECK(!Device.RecoveryPending);
+	TEST_CHECK_EQUAL(1, Device.InterruptCounts[1]);
+	TEST_CHECK_EQUAL(1, Device.InterruptCounts[2]);
+}
+
+static VOID
+UnhandledBitsAreOnlyCounted(
+	VOID
+)
+{
+	StartPlayback();
+
+	AW8624DispatchInterrupts(&Device, AW8624_BIT_SYSINT_OVI | AW8624_BIT_SYSINT_FF_AEI | AW8624_BIT_SYSINT_FF_AFI);
+
+	TEST_CHECK(Device.PlaybackActive);
+	TEST_CHECK(!Device.PlaybackDoneEvent.Signaled);
+	TEST_CHECK_EQUAL(1, Device.InterruptCounts[3]);
+	TEST_CHECK_EQUAL(1, Device.InterruptCounts[4]);
+	TEST_CHECK_EQUAL(1, Device.InterruptCounts[6]);
+	TEST_CHECK_EQUAL(0, FakeChip.Reads + FakeChip.Writes);
+}
+
+static VOID
+ServiceAcknowledgesAndClaims(
+	VOID
+)
+{
+	StartPlayback();
+	FakeChip.Registers[AW8624_REG_SYSINT] = AW8624_BIT_SYSINT_DONEI;
+
+	TEST_CHECK(AW8624InterruptService(&Device));
+	TEST_CHECK_EQUAL(0, FakeChip.Registers[AW8624_REG_SYSINT]);
+	TEST_CHECK(!Device.PlaybackActive);
+
+	// A shared line that was not ours is not claimed
+	TEST_CHECK(!AW8624InterruptService(&Device));
+	TEST_CHECK_EQUAL(1, Device.InterruptCounts[0]);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(TableServicesFaultsBeforeDone);
+	TEST_RUN(DoneEndsPlaybackWithoutBusTraffic);
+	TEST_RUN(UnderVoltageRequestsRecovery);
+	TEST_RUN(DriverFaultsStopTheMotor);
+	TEST_RUN(UnhandledBitsAreOnlyCounted);
+	TEST_RUN(ServiceAcknowledgesAndClaims);
+
+	return TestFailures != 0;
+}
@@ -0,0 +1,317 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	PlanTests.c
+
+Abstract:
+
+	How AW8624PlanCommit splits a register plan into runs, which reads
+	and bursts AW8624PlanWriteRun issues for each of them, and the
+	table-driven AW8624HapticsInit against the sequence it replaced.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+//
+// AW8624HapticsInit as it was before the register table: mode
+// transitions around separate read-modify-writes
+//
+static NTSTATUS
+LegacyHapticsInit(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	NTSTATUS Status = STATUS_SUCCESS;
+	AW8624_REG_TRANSACTION Transaction;
+
+	Status = AW8624Standby(pDevice);
+
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_PWMDBG, AW8624_BIT_PWMDBG_PWM_MODE_MASK, AW8624_BIT_PWMDBG_PWM_24K);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_DETCTRL, AW8624_BIT_DETCTRL_PROTECT_MASK, AW8624_BIT_DETCTRL_PROTECT_NO_ACTION);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_PWMPRC, AW8624_BIT_PWMPRC_PRC_EN_MASK, AW8624_BIT_PWMPRC_PRC_DISABLE);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_PRLVL, AW8624_BIT_PRLVL_PR_EN_MASK, AW8624_BIT_PRLVL_PR_DISABLE);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_ADCTEST, AW8624_BIT_DETCTRL_VBAT_MODE_MASK, AW8624_BIT_DETCTRL_VBAT_HW_COMP);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_R_SPARE, AW8624_BIT_R_SPARE_MASK, AW8624_BIT_R_SPARE_ENABLE);
+	AW8624CommitWithCheck(pDevice, &Transaction);
+
+	AW8624WriteRegWithCheck(pDevice, AW8624_REG_TRIM_LRA, pDevice->TrimLra);
+
+	Status = AW8624Standby(pDevice);
+	Status = AW8624RamMode(pDevice);
+	Status = AW8624Stop(pDevice);
+
+	AW8624WriteRegWithCheck(pDevice, AW8624_REG_SW_BRAKE, pDevice->Profile.SwBrake);
+
+	AW8624WriteRegWithCheck(pDevice, AW8624_REG_THRS_BRA_END, 0x00);
+
+	AW8624WriteBitsWithCheck(pDevice, AW8624_REG_WAVECTRL, AW8624_BIT_WAVECTRL_NUM_OV_DRIVER_MASK, AW8624_BIT_WAVECTRL_NUM_OV_DRIVER);
+
+	AW8624WriteRegWithCheck(pDevice, AW8624_REG_TSET, pDevice->Profile.Tset);
+
+	AW8624WriteBurstWithCheck(pDevice, AW8624_REG_ZC_THRSH_H, pDevice->ProfileImage.Bemf, sizeof(pDevice->ProfileImage.Bemf));
+
+	return Status;
+}
+
+//
+// Power-on contents other than zero, so bits the sequence must keep
+// are actually checked
+//
+static VOID
+PrepareChip(
+	VOID
+)
+{
+	ULONG i = 0;
+
+	HarnessInitializeDevice(&Device);
+
+	Device.Profile = AW8624DefaultProfile;
+	Device.TrimLra = 0x05;
+	AW8624BuildProfileImage(&Device);
+
+	for (i = 0; i < AW8624_REGISTER_COUNT; i++)
+	{
+		FakeChip.Registers[i] = (UCHAR)(i * 37 + 0x5A);
+	}
+
+	FakeChip.Registers[AW8624_REG_SYSINT] = 0;
+}
+
+static VOID
+ContiguousRegistersAreOneBurst(
+	VOID
+)
+{
+	AW8624_REG_PLAN Plan;
+
+	HarnessInitializeDevice(&Device);
+
+	AW8624PlanBegin(&Plan);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMDEL, 0x00, 0x11);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMPRC, 0x00, 0x22);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMDBG, 0x00, 0x33);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624PlanCommit(&Device, &Plan));
+	TEST_CHECK_EQUAL(3, Plan.Registers);
+	TEST_CHECK_EQUAL(1, Plan.Bursts);
+
+	// Whole registers are written without reading them first
+	TEST_CHECK_EQUAL(0, FakeChip.Reads);
+	TEST_CHECK_EQUAL(1, FakeChip.Writes);
+	TEST_CHECK_EQUAL(AW8624_REG_PWMDEL, FakeChip.Log[0].Address);
+	TEST_CHECK_EQUAL(3, FakeChip.Log[0].Length);
+	TEST_CHECK_EQUAL(0x22, FakeChip.Registers[AW8624_REG_PWMPRC]);
+}
+
+static VOID
+GapsSplitRuns(
+	VOID
+)
+{
+	AW8624_REG_PLAN Plan;
+
+	HarnessInitializeDevice(&Device);
+
+	AW8624PlanBegin(&Plan);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMDBG, 0x00, 0x03);
+	AW8624PlanSetBits(&Plan, AW8624_REG_DATCTRL, 0x00, 0x01);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMDEL, 0x00, 0x02);
+	AW8624PlanSetBits(&Plan, AW8624_REG_DBGCTRL, 0x00, 0x04);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624PlanCommit(&Device, &Plan));
+	TEST_CHECK_EQUAL(4, Plan.Registers);
+	TEST_CHECK_EQUAL(3, Plan.Bursts);
+
+	// Runs go out in address order, whatever order they were planned in,
+	// and PWMPRC missing from the plan splits DATCTRL..PWMDBG in two
+	TEST_CHECK_EQUAL(3, FakeChip.LogCount);
+	TEST_CHECK_EQUAL(AW8624_REG_DBGCTRL, FakeChip.Log[0].Address);
+	TEST_CHECK_EQUAL(1, FakeChip.Log[0].Length);
+	TEST_CHECK_EQUAL(AW8624_REG_DATCTRL, FakeChip.Log[1].Address);
+	TEST_CHECK_EQUAL(2, FakeChip.Log[1].Length);
+	TEST_CHECK_EQUAL(0x01, FakeChip.Log[1].Data[0]);
+	TEST_CHECK_EQUAL(0x02, FakeChip.Log[1].Data[1]);
+	TEST_CHECK_EQUAL(AW8624_REG_PWMDBG, FakeChip.Log[2].Address);
+	TEST_CHECK_EQUAL(1, FakeChip.Log[2].Length);
+	TEST_CHECK_EQUAL(0x03, FakeChip.Log[2].Data[0]);
+}
+
+static VOID
+PartialRegistersAreReadInOneSpan(
+	VOID
+)
+{
+	AW8624_REG_PLAN Plan;
+
+	HarnessInitializeDevice(&Device);
+	FakeChip.Registers[AW8624_REG_DATCTRL] = 0xF0;
+	FakeChip.Registers[AW8624_REG_PWMDBG] = 0x0F;
+
+	AW8624PlanBegin(&Plan);
+	AW8624PlanSetBits(&Plan, AW8624_REG_DATCTRL, 0xF0, 0x01);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMDEL, 0x00, 0x02);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMPRC, 0x00, 0x03);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMDBG, 0x0F, 0x40);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624PlanCommit(&Device, &Plan));
+	TEST_CHECK_EQUAL(1, FakeChip.Reads);
+	TEST_CHECK_EQUAL(AW8624_REG_DATCTRL, FakeChip.Log[0].Address);
+	TEST_CHECK_EQUAL(4, FakeChip.Log[0].Length);
+	TEST_CHECK_EQUAL(1, FakeChip.Writes);
+	TEST_CHECK_EQUAL(0xF1, FakeChip.Registers[AW8624_REG_DATCTRL]);
+	TEST_CHECK_EQUAL(0x4F, FakeChip.Registers[AW8624_REG_PWMDBG]);
+}
+
+static VOID
+VolatileRegistersAreNotReadAlong(
+	VOID
+)
+{
+	AW8624_REG_PLAN Plan;
+	ULONG i = 0;
+
+	HarnessInitializeDevice(&Device);
+	FakeChip.Registers[AW8624_REG_SYSCTRL] = 0x80;
+	FakeChip.Registers[AW8624_REG_WAVSEQ1] = 0x80;
+
+	// GO and RTP_DATA sit between the two registers that need reading
+	AW8624PlanBegin(&Plan);
+	AW8624PlanSetBits(&Plan, AW8624_REG_SYSCTRL, 0x80, 0x01);
+	AW8624PlanSetBits(&Plan, AW8624_REG_GO, 0x00, 0x00);
+	AW8624PlanSetBits(&Plan, AW8624_REG_RTP_DATA, 0x00, 0x00);
+	AW8624PlanSetBits(&Plan, AW8624_REG_WAVSEQ1, 0x80, 0x02);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624PlanCommit(&Device, &Plan));
+	TEST_CHECK_EQUAL(2, FakeChip.Reads);
+
+	for (i = 0; i < FakeChip.LogCount; i++)
+	{
+		if (!FakeChip.Log[i].Write)
+		{
+			TEST_CHECK_EQUAL(1, FakeChip.Log[i].Length);
+			TEST_CHECK(!AW8624IsVolatileRegister(FakeChip.Log[i].Address));
+		}
+	}
+
+	TEST_CHECK_EQUAL(1, Plan.Bursts);
+	TEST_CHECK_EQUAL(0x81, FakeChip.Registers[AW8624_REG_SYSCTRL]);
+	TEST_CHECK_EQUAL(0x82, FakeChip.Registers[AW8624_REG_WAVSEQ1]);
+}
+
+static VOID
+RunsTheCacheMatchesAreSkipped(
+	VOID
+)
+{
+	AW8624_REG_PLAN Plan;
+
+	HarnessInitializeDevice(&Device);
+
+	AW8624PlanBegin(&Plan);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMDEL, 0x00, 0x11);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMPRC, 0x00, 0x22);
+	AW8624PlanSetBits(&Plan, AW8624_REG_DBGCTRL, 0x00, 0x04);
+	AW8624PlanCommit(&Device, &Plan);
+
+	FakeChipClearLog();
+
+	// Same values again, with one register of one run changed
+	AW8624PlanBegin(&Plan);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMDEL, 0x00, 0x11);
+	AW8624PlanSetBits(&Plan, AW8624_REG_PWMPRC, 0x00, 0x22);
+	AW8624PlanSetBits(&Plan, AW8624_REG_DBGCTRL, 0x00, 0x05);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624PlanCommit(&Device, &Plan));
+	TEST_CHECK_EQUAL(3, Plan.Registers);
+	TEST_CHECK_EQUAL(1, Plan.Bursts);
+	TEST_CHECK_EQUAL(0, FakeChip.Reads);
+	TEST_CHECK_EQUAL(1, FakeChip.Writes);
+	TEST_CHECK_EQUAL(AW8624_REG_DBGCTRL, FakeChip.Log[0].Address);
+}
+
+static VOID
+SetBitsMergesWithinThePlan(
+	VOID
+)
+{
+	AW8624_REG_PLAN Plan;
+
+	AW8624PlanBegin(&Plan);
+	AW8624PlanSetBits(&Plan, AW8624_REG_SYSCTRL, 0xF0, 0x01);
+	AW8624PlanSetBits(&Plan, AW8624_REG_SYSCTRL, 0x0F, 0x20);
+
+	TEST_CHECK(Plan.Present[AW8624_REG_SYSCTRL]);
+	TEST_CHECK_EQUAL(0x00, Plan.Mask[AW8624_REG_SYSCTRL]);
+	TEST_CHECK_EQUAL(0x21, Plan.Value[AW8624_REG_SYSCTRL]);
+}
+
+static VOID
+HapticsInitMatchesLegacySequence(
+	VOID
+)
+{
+	UCHAR Legacy[AW8624_REGISTER_COUNT];
+	ULONG LegacyTransfers = 0;
+	ULONG LegacyMicroseconds = 0;
+	ULONG Transfers = 0;
+	ULONG Microseconds = 0;
+	ULONG i = 0;
+
+	PrepareChip();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, LegacyHapticsInit(&Device));
+
+	RtlCopyMemory(Legacy, FakeChip.Registers, sizeof(Legacy));
+	LegacyTransfers = FakeChip.Reads + FakeChip.Writes;
+	LegacyMicroseconds = FakeChipBusMicroseconds();
+
+	PrepareChip();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624HapticsInit(&Device));
+
+	Transfers = FakeChip.Reads + FakeChip.Writes;
+	Microseconds = FakeChipBusMicroseconds();
+
+	for (i = 0; i < AW8624_REGISTER_COUNT; i++)
+	{
+		if (Legacy[i] != FakeChip.Registers[i])
+		{
+			printf("register 0x%02X is 0x%02X, the legacy sequence left 0x%02X\n", i, FakeChip.Registers[i], Legacy[i]);
+			TestFailures++;
+		}
+	}
+
+	TEST_CHECK(Transfers < LegacyTransfers);
+	TEST_CHECK(Microseconds < LegacyMicroseconds);
+
+	printf(
+		"HapticsInit: %u transfers, %u us of bus time, legacy sequence %u transfers, %u us\n",
+		Transfers,
+		Microseconds,
+		LegacyTransfers,
+		LegacyMicroseconds);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(ContiguousRegistersAreOneBurst);
+	TEST_RUN(GapsSplitRuns);
+	TEST_RUN(PartialRegistersAreReadInOneSpan);
+	TEST_RUN(VolatileRegistersAreNotReadAlong);
+	TEST_RUN(RunsTheCacheMatchesAreSkipped);
+	TEST_RUN(SetBitsMergesWithinThePlan);
+	TEST_RUN(HapticsInitMatchesLegacySequence);
+
+	return TestFailures != 0;
+}
@@ -0,0 +1,222 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	RamBankTests.c
+
+Abstract:
+
+	AW8624RamUpload writing a waveform bank into the SRAM behind
+	RAMADDR/RAMDATA and verifying it by readback, without a transfer
+	too long for the SPB default buffers.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+#define BANK_BASE_ADDRESS	0x0800
+#define BANK_DATA_LENGTH	600
+
+static UCHAR Bank[AW8624_RAM_BANK_HEADER_SIZE + BANK_DATA_LENGTH];
+
+//
+// Header of checksum and base address, both high byte first. The
+// checksum covers everything after itself.
+//
+static VOID
+BuildBank(
+	UINT16 BaseAddress
+)
+{
+	UINT16 Checksum = 0;
+	ULONG i = 0;
+
+	Bank[2] = (UCHAR)(BaseAddress >> 8);
+	Bank[3] = (UCHAR)(BaseAddress & 0xFF);
+
+	for (i = 0; i < BANK_DATA_LENGTH; i++)
+	{
+		// Differs between chunks, so a misplaced chunk shows
+		Bank[AW8624_RAM_BANK_HEADER_SIZE + i] = (UCHAR)(i * 7 + (i / AW8624_RAM_CHUNK_SIZE) + 1);
+	}
+
+	Checksum = AW8624RamBankChecksum(&Bank[2], sizeof(Bank) - 2);
+	Bank[0] = (UCHAR)(Checksum >> 8);
+	Bank[1] = (UCHAR)(Checksum & 0xFF);
+}
+
+static VOID
+PrepareDevice(
+	VOID
+)
+{
+	HarnessInitializeDevice(&Device);
+	BuildBank(BANK_BASE_ADDRESS);
+}
+
+static ULONG
+RamDataTransfers(
+	BOOLEAN Write
+)
+{
+	ULONG Count = 0;
+	ULONG i = 0;
+
+	for (i = 0; i < FakeChip.LogCount; i++)
+	{
+		if (FakeChip.Log[i].Write == Write && FakeChip.Log[i].Address == AW8624_REG_RAMDATA)
+		{
+			TEST_CHECK(FakeChip.Log[i].Length <= AW8624_RAM_CHUNK_SIZE);
+			Count++;
+		}
+	}
+
+	return Count;
+}
+
+static VOID
+CorruptFirstReadback(
+	UCHAR Address,
+	ULONG Length
+)
+{
+	UNREFERENCED_PARAMETER(Length);
+
+	if (Address == AW8624_REG_RAMDATA)
+	{
+		FakeChip.Sram[BANK_BASE_ADDRESS] ^= 0xFF;
+		FakeChip.ReadHook = NULL;
+	}
+}
+
+static VOID
+UploadLandsAtTheBaseAddress(
+	VOID
+)
+{
+	ULONG Chunks = (BANK_DATA_LENGTH + AW8624_RAM_CHUNK_SIZE - 1) / AW8624_RAM_CHUNK_SIZE;
+	ULONG i = 0;
+
+	PrepareDevice();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624RamUpload(&Device, Bank, sizeof(Bank)));
+	TEST_CHECK(Device.RamBankLoaded);
+	TEST_CHECK_EQUAL(BANK_BASE_ADDRESS, Device.RamBaseAddress);
+
+	for (i = 0; i < BANK_DATA_LENGTH; i++)
+	{
+		TEST_CHECK_EQUAL(Bank[AW8624_RAM_BANK_HEADER_SIZE + i], FakeChip.Sram[BANK_BASE_ADDRESS + i]);
+	}
+
+	TEST_CHECK_EQUAL(0, FakeChip.Sram[BANK_BASE_ADDRESS - 1]);
+	TEST_CHECK_EQUAL(0, FakeChip.Sram[BANK_BASE_ADDRESS + BANK_DATA_LENGTH]);
+
+	// The RTP FIFO below the bank, half and three quarters full
+	TEST_CHECK_EQUAL(BANK_BASE_ADDRESS >> 8, FakeChip.Registers[AW8624_REG_BASE_ADDRH]);
+	TEST_CHECK_EQUAL(BANK_BASE_ADDRESS & 0xFF, FakeChip.Registers[AW8624_REG_BASE_ADDRL]);
+	TEST_CHECK_EQUAL(0x04, FakeChip.Registers[AW8624_REG_FIFO_AEH]);
+	TEST_CHECK_EQUAL(0x06, FakeChip.Registers[AW8624_REG_FIFO_AFH]);
+
+	// One pointer write each way, then whole chunks
+	TEST_CHECK_EQUAL(2, FakeChipWritesTo(AW8624_REG_RAMADDRH));
+	TEST_CHECK_EQUAL(Chunks, RamDataTransfers(TRUE));
+	TEST_CHECK_EQUAL(Chunks, RamDataTransfers(FALSE));
+
+	TEST_CHECK_EQUAL(0, FakeChip.Registers[AW8624_REG_SYSCTRL] & AW8624_BIT_SYSCTRL_RAMINIT_EN);
+}
+
+static VOID
+ReadbackMismatchFails(
+	VOID
+)
+{
+	PrepareDevice();
+	FakeChip.ReadHook = CorruptFirstReadback;
+
+	TEST_CHECK_EQUAL(STATUS_CRC_ERROR, AW8624RamUpload(&Device, Bank, sizeof(Bank)));
+	TEST_CHECK(!Device.RamBankLoaded);
+	TEST_CHECK_EQUAL(0, FakeChip.Registers[AW8624_REG_SYSCTRL] & AW8624_BIT_SYSCTRL_RAMINIT_EN);
+}
+
+static VOID
+BadBanksNeverReachTheBus(
+	VOID
+)
+{
+	PrepareDevice();
+	Bank[AW8624_RAM_BANK_HEADER_SIZE] ^= 0xFF;
+
+	TEST_CHECK_EQUAL(STATUS_FILE_CORRUPT_ERROR, AW8624RamUpload(&Device, Bank, sizeof(Bank)));
+	TEST_CHECK_EQUAL(0, FakeChip.Reads + FakeChip.Writes);
+
+	// Past the end of the SRAM
+	BuildBank((UINT16)(AW8624_SRAM_SIZE - BANK_DATA_LENGTH + 1));
+
+	TEST_CHECK_EQUAL(STATUS_INVALID_BUFFER_SIZE, AW8624RamUpload(&Device, Bank, sizeof(Bank)));
+	TEST_CHECK_EQUAL(0, FakeChip.Reads + FakeChip.Writes);
+
+	TEST_CHECK_EQUAL(STATUS_INVALID_BUFFER_SIZE, AW8624RamUpload(&Device, Bank, AW8624_RAM_BANK_HEADER_SIZE));
+	TEST_CHECK(!Device.RamBankLoaded);
+}
+
+static VOID
+RepeatedUploadsNeverAllocate(
+	VOID
+)
+{
+	UCHAR Burst[SPB_MAX_BURST_SIZE + 1];
+	ULONG Transfers = 0;
+	ULONG Oversized = 0;
+	ULONG i = 0;
+
+	PrepareDevice();
+
+	for (i = 0; i < 100; i++)
+	{
+		FakeChipClearLog();
+
+		TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624RamUpload(&Device, Bank, sizeof(Bank)));
+		Oversized += FakeChip.Oversized;
+
+		// Once SYSCTRL is cached, every upload costs the same transfers
+		if (i == 1)
+		{
+			Transfers = FakeChip.Reads + FakeChip.Writes;
+		}
+		else if (i > 1)
+		{
+			TEST_CHECK_EQUAL(Transfers, FakeChip.Reads + FakeChip.Writes);
+		}
+	}
+
+	TEST_CHECK_EQUAL(0, Oversized);
+
+	// A full chunk fits, one byte more is what would allocate
+	RtlZeroMemory(Burst, sizeof(Burst));
+	FakeChipClearLog();
+
+	AW8624SpbWriteBurst(&Device, AW8624_REG_RAMDATA, Burst, AW8624_RAM_CHUNK_SIZE);
+	TEST_CHECK_EQUAL(0, FakeChip.Oversized);
+
+	AW8624SpbWriteBurst(&Device, AW8624_REG_RAMDATA, Burst, sizeof(Burst));
+	TEST_CHECK_EQUAL(1, FakeChip.Oversized);
+
+	printf("RAM bank upload: %u transfers, %u oversized in 100 uploads\n", Transfers, Oversized);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(UploadLandsAtTheBaseAddress);
+	TEST_RUN(ReadbackMismatchFails);
+	TEST_RUN(BadBanksNeverReachTheBus);
+	TEST_RUN(RepeatedUploadsNeverAllocate);
+
+	return TestFailures != 0;
+}
@@ -0,0 +1,170 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	RegisterAccessTests.c
+
+Abstract:
+
+	Access widths on the bus: single registers move one byte, H/L pairs
+	and the continuous mode image go out as auto-increment bursts, high
+	byte first, without spilling into neighbouring registers.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+// Neither zero nor anything the driver writes
+#define UNTOUCHED 0xEE
+
+static VOID
+PrepareDevice(
+	VOID
+)
+{
+	HarnessInitializeDevice(&Device);
+
+	Device.Profile = AW8624DefaultProfile;
+	AW8624BuildProfileImage(&Device);
+
+	RtlFillMemory(FakeChip.Registers, sizeof(FakeChip.Registers), UNTOUCHED);
+}
+
+static PFAKE_CHIP_TRANSFER
+FindWrite(
+	UCHAR Address
+)
+{
+	ULONG i = 0;
+
+	for (i = 0; i < FakeChip.LogCount; i++)
+	{
+		if (FakeChip.Log[i].Write && FakeChip.Log[i].Address == Address)
+		{
+			return &FakeChip.Log[i];
+		}
+	}
+
+	return NULL;
+}
+
+static VOID
+SingleRegistersMoveOneByte(
+	VOID
+)
+{
+	UINT8 RegData = 0;
+
+	PrepareDevice();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624SpbWrite(&Device, AW8624_REG_PWMDBG, 0x12));
+	TEST_CHECK_EQUAL(1, FakeChip.Log[0].Length);
+	TEST_CHECK_EQUAL(0x12, FakeChip.Registers[AW8624_REG_PWMDBG]);
+	TEST_CHECK_EQUAL(UNTOUCHED, FakeChip.Registers[AW8624_REG_PWMDBG + 1]);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624SpbRead(&Device, AW8624_REG_PWMDEL, &RegData, sizeof(RegData)));
+	TEST_CHECK_EQUAL(1, FakeChip.Log[1].Length);
+	TEST_CHECK_EQUAL(UNTOUCHED, RegData);
+
+	// A read-modify-write reads and writes the one register
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624WriteBits(&Device, AW8624_REG_PRLVL, 0x7F, 0x00));
+	TEST_CHECK_EQUAL(4, FakeChip.LogCount);
+	TEST_CHECK_EQUAL(1, FakeChip.Log[2].Length);
+	TEST_CHECK_EQUAL(1, FakeChip.Log[3].Length);
+	TEST_CHECK_EQUAL(0x6E, FakeChip.Registers[AW8624_REG_PRLVL]);
+	TEST_CHECK_EQUAL(UNTOUCHED, FakeChip.Registers[AW8624_REG_PRLVL + 1]);
+}
+
+static VOID
+PairsAreOneBurstHighByteFirst(
+	VOID
+)
+{
+	PrepareDevice();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624SpbWrite16(&Device, AW8624_REG16_F_PRE, 0x1234));
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624SpbWrite16(&Device, AW8624_REG16_TD, 0xF06C));
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624SpbWrite16(&Device, AW8624_REG16_ZC_THRSH, 0x08F8));
+
+	TEST_CHECK_EQUAL(3, FakeChip.Writes);
+
+	TEST_CHECK_EQUAL(AW8624_REG_F_PRE_H, FakeChip.Log[0].Address);
+	TEST_CHECK_EQUAL(2, FakeChip.Log[0].Length);
+	TEST_CHECK_EQUAL(0x12, FakeChip.Log[0].Data[0]);
+	TEST_CHECK_EQUAL(0x34, FakeChip.Log[0].Data[1]);
+
+	TEST_CHECK_EQUAL(0x12, FakeChip.Registers[AW8624_REG_F_PRE_H]);
+	TEST_CHECK_EQUAL(0x34, FakeChip.Registers[AW8624_REG_F_PRE_L]);
+	TEST_CHECK_EQUAL(0xF0, FakeChip.Registers[AW8624_REG_TD_H]);
+	TEST_CHECK_EQUAL(0x6C, FakeChip.Registers[AW8624_REG_TD_L]);
+	TEST_CHECK_EQUAL(0x08, FakeChip.Registers[AW8624_REG_ZC_THRSH_H]);
+	TEST_CHECK_EQUAL(0xF8, FakeChip.Registers[AW8624_REG_ZC_THRSH_L]);
+
+	TEST_CHECK_EQUAL(UNTOUCHED, FakeChip.Registers[AW8624_REG_TSET]);
+	TEST_CHECK_EQUAL(UNTOUCHED, FakeChip.Registers[AW8624_REG_BEMF_VTHH_H]);
+}
+
+static VOID
+ContinuousModeImageByteByByte(
+	VOID
+)
+{
+	static const UCHAR Bemf[] = { 0x08, 0xF8, 0x00, 0x08, 0x03, 0xF8 };
+	UINT16 Period = 0;
+	PFAKE_CHIP_TRANSFER Transfer = NULL;
+	ULONG i = 0;
+
+	PrepareDevice();
+
+	Period = AW8624F0Period(&Device, AW8624DefaultProfile.F0Preset);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624PrepareContinuousMode(&Device));
+
+	// F_PRE_H/L, TD_H/L and TSET
+	Transfer = FindWrite(AW8624_REG_F_PRE_H);
+	TEST_CHECK(Transfer != NULL);
+
+	if (Transfer != NULL)
+	{
+		TEST_CHECK_EQUAL(5, Transfer->Length);
+		TEST_CHECK_EQUAL(Period >> 8, Transfer->Data[0]);
+		TEST_CHECK_EQUAL(Period & 0xFF, Transfer->Data[1]);
+		TEST_CHECK_EQUAL(0xF0, Transfer->Data[2]);
+		TEST_CHECK_EQUAL(0x6C, Transfer->Data[3]);
+		TEST_CHECK_EQUAL(0x11, Transfer->Data[4]);
+	}
+
+	// ZC_THRSH_H/L, then vib_bemf_config into BEMF_VTHH_H through BEMF_VTHL_L
+	Transfer = FindWrite(AW8624_REG_ZC_THRSH_H);
+	TEST_CHECK(Transfer != NULL);
+
+	if (Transfer != NULL)
+	{
+		TEST_CHECK_EQUAL(sizeof(Bemf), Transfer->Length);
+
+		for (i = 0; i < sizeof(Bemf); i++)
+		{
+			TEST_CHECK_EQUAL(Bemf[i], Transfer->Data[i]);
+			TEST_CHECK_EQUAL(Bemf[i], FakeChip.Registers[AW8624_REG_ZC_THRSH_H + i]);
+		}
+	}
+
+	TEST_CHECK_EQUAL(UNTOUCHED, FakeChip.Registers[AW8624_REG_TSET + 1]);
+	TEST_CHECK_EQUAL(UNTOUCHED, FakeChip.Registers[AW8624_REG_ZC_THRSH_H - 1]);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(SingleRegistersMoveOneByte);
+	TEST_RUN(PairsAreOneBurstHighByteFirst);
+	TEST_RUN(ContinuousModeImageByteByByte);
+
+	return TestFailures != 0;
+}
@@ -0,0 +1,230 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	ResumeTests.c
+
+Abstract:
+
+	AW8624Suspend, and AW8624Resume telling a chip that kept its state
+	from one that lost power and restoring the latter from the register
+	cache.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+//
+// A device through its first D0 entry and back out of D0
+//
+static VOID
+PrepareSuspendedDevice(
+	VOID
+)
+{
+	HarnessInitializeDevice(&Device);
+	KeInitializeEvent(&Device.PlaybackDoneEvent, NotificationEvent, FALSE);
+
+	Device.Profile = AW8624DefaultProfile;
+	AW8624BuildProfileImage(&Device);
+	Device.SetupWorkItem = (WDFWORKITEM)&Device;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Initialize(&Device));
+
+	// As the setup work item leaves it
+	Device.RamBankLoaded = TRUE;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Suspend(&Device));
+
+	FakeChipClearLog();
+	HarnessWorkItemsQueued = 0;
+}
+
+static VOID
+SuspendStopsPlayback(
+	VOID
+)
+{
+	PrepareSuspendedDevice();
+
+	Device.PlaybackActive = TRUE;
+	Device.Blink.Active = TRUE;
+	Device.PreviousState = HWN_ON;
+
+	// DONE arrives while braking
+	KeSetEvent(&Device.PlaybackDoneEvent, IO_NO_INCREMENT, FALSE);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Suspend(&Device));
+	TEST_CHECK_EQUAL(1, FakeChipWritesTo(AW8624_REG_GO));
+	TEST_CHECK_EQUAL(AW8624_BIT_GO_DISABLE, FakeChip.Registers[AW8624_REG_GO]);
+	TEST_CHECK_EQUAL(AW8624_BIT_SYSCTRL_STANDBY, FakeChip.Registers[AW8624_REG_SYSCTRL] & ~AW8624_BIT_SYSCTRL_WORK_MODE_MASK);
+	TEST_CHECK_EQUAL(0, Device.StopTimeouts);
+	TEST_CHECK(!Device.PlaybackActive);
+	TEST_CHECK(!Device.Blink.Active);
+	TEST_CHECK_EQUAL(HWN_OFF, Device.PreviousState);
+}
+
+static VOID
+WarmResumeWritesNothing(
+	VOID
+)
+{
+	PrepareSuspendedDevice();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Resume(&Device));
+	TEST_CHECK_EQUAL(1, Device.WarmResumes);
+	TEST_CHECK_EQUAL(0, Device.ColdResumes);
+
+	// One read of the signature registers and nothing else
+	TEST_CHECK_EQUAL(1, FakeChip.Reads);
+	TEST_CHECK_EQUAL(0, FakeChip.Writes);
+	TEST_CHECK_EQUAL(AW8624_RESUME_SIGNATURE, FakeChip.Log[0].Address);
+	TEST_CHECK_EQUAL(AW8624_RESUME_SIGNATURE_LENGTH, FakeChip.Log[0].Length);
+	TEST_CHECK_EQUAL(0, HarnessWorkItemsQueued);
+	TEST_CHECK(Device.RamBankLoaded);
+}
+
+static VOID
+ColdResumeRestoresTheCache(
+	VOID
+)
+{
+	AW8624_REGISTER_CACHE Image;
+	ULONG Runs = 0;
+	ULONG Write = 0;
+	ULONG i = 0;
+
+	PrepareSuspendedDevice();
+
+	RtlCopyMemory(&Image, &Device.RegisterCache, sizeof(Image));
+
+	for (i = 0; i < AW8624_REGISTER_COUNT; i++)
+	{
+		if (Image.Valid[i] && (i == 0 || !Image.Valid[i - 1]))
+		{
+			Runs++;
+		}
+	}
+
+	FakeChipPowerCycle();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Resume(&Device));
+	TEST_CHECK_EQUAL(0, Device.WarmResumes);
+	TEST_CHECK_EQUAL(1, Device.ColdResumes);
+
+	// The signature, then SYSINT after the restore
+	TEST_CHECK_EQUAL(2, FakeChip.Reads);
+	TEST_CHECK_EQUAL(Runs, FakeChip.Writes);
+
+	//
+	// One burst per run of cached registers, in address order,
+	// each starting where a run starts and covering all of it
+	//
+	for (i = 0; i < FakeChip.LogCount; i++)
+	{
+		if (!FakeChip.Log[i].Write)
+		{
+			continue;
+		}
+
+		TEST_CHECK(Image.Valid[FakeChip.Log[i].Address]);
+		TEST_CHECK(FakeChip.Log[i].Address == 0 || !Image.Valid[FakeChip.Log[i].Address - 1]);
+		TEST_CHECK(FakeChip.Log[i].Address + FakeChip.Log[i].Length == AW8624_REGISTER_COUNT ||
+			!Image.Valid[FakeChip.Log[i].Address + FakeChip.Log[i].Length]);
+		TEST_CHECK(FakeChip.Log[i].Address >= Write);
+
+		Write = FakeChip.Log[i].Address + FakeChip.Log[i].Length;
+	}
+
+	for (i = 0; i < AW8624_REGISTER_COUNT; i++)
+	{
+		if (Image.Valid[i])
+		{
+			TEST_CHECK_EQUAL(Image.Value[i], FakeChip.Registers[i]);
+		}
+	}
+
+	// The SRAM is reloaded from the setup work item
+	TEST_CHECK(!Device.RamBankLoaded);
+	TEST_CHECK_EQUAL(1, HarnessWorkItemsQueued);
+}
+
+static VOID
+ResumeWithoutSignatureInitializes(
+	VOID
+)
+{
+	PrepareSuspendedDevice();
+
+	AW8624CacheInvalidate(&Device);
+	FakeChipPowerCycle();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Resume(&Device));
+	TEST_CHECK_EQUAL(1, Device.ColdResumes);
+	TEST_CHECK_EQUAL(1, FakeChipWritesTo(AW8624_REG_ID));
+	TEST_CHECK_EQUAL(1, HarnessWorkItemsQueued);
+}
+
+static VOID
+ResumeBenchmark(
+	VOID
+)
+{
+	ULONG WarmTransfers = 0;
+	ULONG WarmMicroseconds = 0;
+	ULONG ColdTransfers = 0;
+	ULONG ColdMicroseconds = 0;
+	ULONG InitializeTransfers = 0;
+	ULONG InitializeMicroseconds = 0;
+
+	PrepareSuspendedDevice();
+	AW8624Resume(&Device);
+
+	WarmTransfers = FakeChip.Reads + FakeChip.Writes;
+	WarmMicroseconds = FakeChipBusMicroseconds();
+
+	PrepareSuspendedDevice();
+	FakeChipPowerCycle();
+	AW8624Resume(&Device);
+
+	ColdTransfers = FakeChip.Reads + FakeChip.Writes;
+	ColdMicroseconds = FakeChipBusMicroseconds();
+
+	// What every D0 entry cost before the cache was restored from
+	PrepareSuspendedDevice();
+	FakeChipPowerCycle();
+	AW8624Initialize(&Device);
+
+	InitializeTransfers = FakeChip.Reads + FakeChip.Writes;
+	InitializeMicroseconds = FakeChipBusMicroseconds();
+
+	TEST_CHECK(WarmMicroseconds < ColdMicroseconds);
+	TEST_CHECK(ColdMicroseconds < InitializeMicroseconds);
+
+	printf(
+		"Resume: warm %u transfers, %u us; cold %u transfers, %u us; full initialization %u transfers, %u us\n",
+		WarmTransfers,
+		WarmMicroseconds,
+		ColdTransfers,
+		ColdMicroseconds,
+		InitializeTransfers,
+		InitializeMicroseconds);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(SuspendStopsPlayback);
+	TEST_RUN(WarmResumeWritesNothing);
+	TEST_RUN(ColdResumeRestoresTheCache);
+	TEST_RUN(ResumeWithoutSignatureInitializes);
+	TEST_RUN(ResumeBenchmark);
+
+	return TestFailures != 0;
+}
@@ -0,0 +1,220 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	StopTests.c
+
+Abstract:
+
+	AW8624Stop completing on the DONE interrupt, the bounded GLB_STATE
+	polling it falls back to when DONE never arrives, and the polls
+	each path costs.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+// GLB_STATE reads the braking chip answers with a non-idle state
+static ULONG BrakingPolls;
+
+static VOID
+PrepareDevice(
+	VOID
+)
+{
+	HarnessInitializeDevice(&Device);
+	KeInitializeEvent(&Device.PlaybackDoneEvent, NotificationEvent, FALSE);
+
+	Device.Profile = AW8624DefaultProfile;
+	AW8624BuildProfileImage(&Device);
+	AW8624BuildDriveLevels(&Device);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Vibrate(&Device, 100));
+	TEST_CHECK(Device.PlaybackActive);
+
+	FakeChipClearLog();
+}
+
+// The chip finishes braking while the driver waits, and raises DONE
+static VOID
+RaiseDone(
+	VOID
+)
+{
+	FakeChip.Registers[AW8624_REG_SYSINT] = AW8624_BIT_SYSINT_DONEI;
+	TEST_CHECK(AW8624InterruptService(&Device));
+}
+
+static VOID
+Brake(
+	UCHAR Address,
+	ULONG Length
+)
+{
+	UNREFERENCED_PARAMETER(Length);
+
+	if (Address != AW8624_REG_GLB_STATE)
+	{
+		return;
+	}
+
+	if (BrakingPolls != 0)
+	{
+		BrakingPolls--;
+		FakeChip.Registers[AW8624_REG_GLB_STATE] = 0x07;
+	}
+	else
+	{
+		FakeChip.Registers[AW8624_REG_GLB_STATE] = 0x00;
+	}
+}
+
+static ULONG
+StatePolls(
+	VOID
+)
+{
+	ULONG Count = 0;
+	ULONG i = 0;
+
+	for (i = 0; i < FakeChip.LogCount; i++)
+	{
+		if (!FakeChip.Log[i].Write && FakeChip.Log[i].Address == AW8624_REG_GLB_STATE)
+		{
+			Count++;
+		}
+	}
+
+	return Count;
+}
+
+static VOID
+DoneCompletesTheStop(
+	VOID
+)
+{
+	PrepareDevice();
+	HarnessWaitHook = RaiseDone;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Stop(&Device));
+	TEST_CHECK_EQUAL(WDF_REL_TIMEOUT_IN_MS(AW8624_STOP_TIMEOUT_MS), HarnessWaitTimeout);
+
+	TEST_CHECK_EQUAL(0, StatePolls());
+	TEST_CHECK_EQUAL(0, Device.StopTimeouts);
+	TEST_CHECK(!Device.PlaybackActive);
+	TEST_CHECK_EQUAL(AW8624_BIT_GO_DISABLE, FakeChip.Registers[AW8624_REG_GO]);
+
+	// GO, the interrupt's SYSINT read, then standby
+	TEST_CHECK_EQUAL(AW8624_REG_GO, FakeChip.Log[0].Address);
+	TEST_CHECK_EQUAL(1, FakeChip.Reads);
+	TEST_CHECK_EQUAL(AW8624_REG_SYSINT, FakeChip.Log[1].Address);
+	TEST_CHECK_EQUAL(AW8624_BIT_SYSCTRL_STANDBY, FakeChip.Registers[AW8624_REG_SYSCTRL] & ~AW8624_BIT_SYSCTRL_WORK_MODE_MASK);
+}
+
+static VOID
+MissingDoneFallsBackToPolling(
+	VOID
+)
+{
+	PrepareDevice();
+	FakeChip.ReadHook = Brake;
+	BrakingPolls = 3;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Stop(&Device));
+
+	// Three polls find it braking, the fourth finds it idle
+	TEST_CHECK_EQUAL(4, StatePolls());
+	TEST_CHECK_EQUAL(1, Device.StopTimeouts);
+	TEST_CHECK_EQUAL(AW8624_BIT_SYSCTRL_STANDBY, FakeChip.Registers[AW8624_REG_SYSCTRL] & ~AW8624_BIT_SYSCTRL_WORK_MODE_MASK);
+}
+
+static VOID
+PollingIsBounded(
+	VOID
+)
+{
+	PrepareDevice();
+	FakeChip.ReadHook = Brake;
+	BrakingPolls = AW8624_STOP_POLL_COUNT * 2;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Stop(&Device));
+	TEST_CHECK_EQUAL(AW8624_STOP_POLL_COUNT, StatePolls());
+	TEST_CHECK_EQUAL(1, Device.StopTimeouts);
+}
+
+static VOID
+IdleStopNeverWaits(
+	VOID
+)
+{
+	PrepareDevice();
+
+	// DONE already ended playback
+	RaiseDone();
+	FakeChipClearLog();
+
+	HarnessWaitTimeout = 0;
+	HarnessWaitHook = RaiseDone;
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Stop(&Device));
+	TEST_CHECK_EQUAL(0, HarnessWaitTimeout);
+	TEST_CHECK_EQUAL(0, FakeChip.Reads);
+	TEST_CHECK_EQUAL(0, Device.StopTimeouts);
+}
+
+static VOID
+StopBenchmark(
+	VOID
+)
+{
+	ULONG DoneTransfers = 0;
+	ULONG DoneMicroseconds = 0;
+	ULONG PollTransfers = 0;
+	ULONG PollMicroseconds = 0;
+	ULONG Polls = 0;
+
+	PrepareDevice();
+	HarnessWaitHook = RaiseDone;
+	AW8624Stop(&Device);
+
+	DoneTransfers = FakeChip.Reads + FakeChip.Writes;
+	DoneMicroseconds = FakeChipBusMicroseconds();
+
+	// A stop that brakes for 20 polls without DONE, as every stop did before
+	PrepareDevice();
+	FakeChip.ReadHook = Brake;
+	BrakingPolls = 20;
+	AW8624Stop(&Device);
+
+	PollTransfers = FakeChip.Reads + FakeChip.Writes;
+	PollMicroseconds = FakeChipBusMicroseconds();
+	Polls = StatePolls();
+
+	TEST_CHECK(DoneMicroseconds < PollMicroseconds);
+
+	printf(
+		"Stop: on DONE %u transfers, %u us; polling %u transfers, %u us, %u polls\n",
+		DoneTransfers,
+		DoneMicroseconds,
+		PollTransfers,
+		PollMicroseconds,
+		Polls);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(DoneCompletesTheStop);
+	TEST_RUN(MissingDoneFallsBackToPolling);
+	TEST_RUN(PollingIsBounded);
+	TEST_RUN(IdleStopNeverWaits);
+	TEST_RUN(StopBenchmark);
+
+	return TestFailures != 0;
+}
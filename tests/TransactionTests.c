@@ -0,0 +1,251 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	TransactionTests.c
+
+Abstract:
+
+	AW8624TransactionSetBits merging, what AW8624TransactionCommit
+	puts on the bus, and the transfers each sequence built on it costs.
+
+--*/
+
+#include "aw8624.c"
+#include "Harness.h"
+
+static DEVICE_CONTEXT Device;
+
+static VOID
+SetBitsMergesMasksOfOneRegister(
+	VOID
+)
+{
+	AW8624_REG_TRANSACTION Transaction;
+
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSCTRL, 0xF0, 0x01);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSCTRL, 0x0F, 0x20);
+
+	TEST_CHECK_EQUAL(1, Transaction.Count);
+	TEST_CHECK_EQUAL(AW8624_REG_SYSCTRL, Transaction.Updates[0].Address);
+	TEST_CHECK_EQUAL(0x00, Transaction.Updates[0].Mask);
+	TEST_CHECK_EQUAL(0x21, Transaction.Updates[0].Value);
+}
+
+static VOID
+SetBitsLaterValueWins(
+	VOID
+)
+{
+	AW8624_REG_TRANSACTION Transaction;
+
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSCTRL, 0xFE, 0x01);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSCTRL, 0xFE, 0x00);
+
+	TEST_CHECK_EQUAL(1, Transaction.Count);
+	TEST_CHECK_EQUAL(0xFE, Transaction.Updates[0].Mask);
+	TEST_CHECK_EQUAL(0x00, Transaction.Updates[0].Value);
+}
+
+static VOID
+SetBitsKeepsOrderOfFirstUse(
+	VOID
+)
+{
+	AW8624_REG_TRANSACTION Transaction;
+
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_DBGCTRL, 0xF7, 0x08);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSCTRL, 0xFE, 0x01);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_DBGCTRL, 0xEF, 0x10);
+
+	TEST_CHECK_EQUAL(2, Transaction.Count);
+	TEST_CHECK_EQUAL(AW8624_REG_DBGCTRL, Transaction.Updates[0].Address);
+	TEST_CHECK_EQUAL(AW8624_REG_SYSCTRL, Transaction.Updates[1].Address);
+	TEST_CHECK_EQUAL(0xE7, Transaction.Updates[0].Mask);
+	TEST_CHECK_EQUAL(0x18, Transaction.Updates[0].Value);
+}
+
+static VOID
+OverflowFailsCommitWithoutBusTraffic(
+	VOID
+)
+{
+	AW8624_REG_TRANSACTION Transaction;
+	ULONG i = 0;
+
+	HarnessInitializeDevice(&Device);
+
+	AW8624TransactionBegin(&Transaction);
+
+	for (i = 0; i <= AW8624_MAX_TRANSACTION_UPDATES; i++)
+	{
+		AW8624TransactionSetBits(&Transaction, (UCHAR)(AW8624_REG_DBGCTRL + i), 0x00, 0x00);
+	}
+
+	TEST_CHECK(Transaction.Overflow);
+	TEST_CHECK_EQUAL(STATUS_INSUFFICIENT_RESOURCES, AW8624TransactionCommit(&Device, &Transaction));
+	TEST_CHECK_EQUAL(0, FakeChip.Reads + FakeChip.Writes);
+}
+
+static VOID
+CommitWritesEachRegisterOnce(
+	VOID
+)
+{
+	AW8624_REG_TRANSACTION Transaction;
+
+	HarnessInitializeDevice(&Device);
+	FakeChip.Registers[AW8624_REG_SYSCTRL] = 0xC3;
+
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSCTRL, 0xFE, 0x00);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSCTRL, 0xF3, 0x08);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624TransactionCommit(&Device, &Transaction));
+	TEST_CHECK_EQUAL(1, FakeChip.Reads);
+	TEST_CHECK_EQUAL(1, FakeChip.Writes);
+	TEST_CHECK_EQUAL(0xCA, FakeChip.Registers[AW8624_REG_SYSCTRL]);
+	TEST_CHECK_EQUAL(0, Transaction.Count);
+}
+
+static VOID
+CommitSkipsRegistersAlreadyHeld(
+	VOID
+)
+{
+	AW8624_REG_TRANSACTION Transaction;
+
+	HarnessInitializeDevice(&Device);
+	FakeChip.Registers[AW8624_REG_SYSCTRL] = 0xCA;
+
+	AW8624TransactionBegin(&Transaction);
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSCTRL, 0xF2, 0x08);
+	AW8624TransactionCommit(&Device, &Transaction);
+
+	// The first commit read SYSCTRL, the second is served from the cache
+	FakeChipClearLog();
+
+	AW8624TransactionSetBits(&Transaction, AW8624_REG_SYSCTRL, 0xF2, 0x08);
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624TransactionCommit(&Device, &Transaction));
+	TEST_CHECK_EQUAL(0, FakeChip.Reads + FakeChip.Writes);
+}
+
+typedef NTSTATUS AW8624_SEQUENCE(PDEVICE_CONTEXT pDevice);
+
+static NTSTATUS
+VibrateSequence(
+	PDEVICE_CONTEXT pDevice
+)
+{
+	return AW8624VibrateUntilStopped(pDevice, 100);
+}
+
+static VOID
+PrepareColdDevice(
+	VOID
+)
+{
+	HarnessInitializeDevice(&Device);
+	KeInitializeEvent(&Device.PlaybackDoneEvent, NotificationEvent, FALSE);
+
+	Device.Profile = AW8624DefaultProfile;
+	AW8624BuildProfileImage(&Device);
+	AW8624BuildDriveLevels(&Device);
+}
+
+//
+// Runs Sequence with an empty cache against a chip holding the
+// complement of what the sequence leaves behind, so every register it
+// touches has to be written
+//
+static VOID
+RunCold(
+	AW8624_SEQUENCE* Sequence
+)
+{
+	UCHAR Image[AW8624_REGISTER_COUNT];
+	ULONG i = 0;
+
+	PrepareColdDevice();
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, Sequence(&Device));
+
+	for (i = 0; i < AW8624_REGISTER_COUNT; i++)
+	{
+		Image[i] = (UCHAR)~FakeChip.Registers[i];
+	}
+
+	PrepareColdDevice();
+	RtlCopyMemory(FakeChip.Registers, Image, sizeof(Image));
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, Sequence(&Device));
+
+	// Each register goes out at most once, however many updates it took
+	for (i = 0; i < AW8624_REGISTER_COUNT; i++)
+	{
+		TEST_CHECK(FakeChipWritesTo((UCHAR)i) <= 1);
+	}
+}
+
+static VOID
+SequenceTransactionCounts(
+	VOID
+)
+{
+	// Plan spans read for the partial registers, then one burst per run
+	RunCold(AW8624HapticsInit);
+	TEST_CHECK_EQUAL(8, FakeChip.Reads);
+	TEST_CHECK_EQUAL(13, FakeChip.Writes);
+
+	//
+	// Nine read-modify-writes of CONT_CTRL and DATCTRL become one write
+	// each, then mode select, SYSINT, UVLO and GO
+	//
+	RunCold(VibrateSequence);
+	TEST_CHECK_EQUAL(7, FakeChip.Reads);
+	TEST_CHECK_EQUAL(10, FakeChip.Writes);
+	TEST_CHECK_EQUAL(1, FakeChipWritesTo(AW8624_REG_CONT_CTRL));
+	TEST_CHECK_EQUAL(1, FakeChipWritesTo(AW8624_REG_DATCTRL));
+
+	// SYSINTM, SYSCTRL and DBGCTRL, and nothing at all once cached
+	RunCold(AW8624Standby);
+	TEST_CHECK_EQUAL(3, FakeChip.Reads);
+	TEST_CHECK_EQUAL(3, FakeChip.Writes);
+
+	FakeChipClearLog();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624Standby(&Device));
+	TEST_CHECK_EQUAL(0, FakeChip.Reads + FakeChip.Writes);
+
+	// Acknowledging SYSINT, then DBGCTRL and four masks in SYSINTM
+	RunCold(AW8624SetupInterrupts);
+	TEST_CHECK_EQUAL(3, FakeChip.Reads);
+	TEST_CHECK_EQUAL(2, FakeChip.Writes);
+
+	// Once cached, only the acknowledge is left
+	FakeChipClearLog();
+
+	TEST_CHECK_EQUAL(STATUS_SUCCESS, AW8624SetupInterrupts(&Device));
+	TEST_CHECK_EQUAL(1, FakeChip.Reads);
+	TEST_CHECK_EQUAL(0, FakeChip.Writes);
+}
+
+int
+main(
+	VOID
+)
+{
+	TEST_RUN(SetBitsMergesMasksOfOneRegister);
+	TEST_RUN(SetBitsLaterValueWins);
+	TEST_RUN(SetBitsKeepsOrderOfFirstUse);
+	TEST_RUN(OverflowFailsCommitWithoutBusTraffic);
+	TEST_RUN(CommitWritesEachRegisterOnce);
+	TEST_RUN(CommitSkipsRegistersAlreadyHeld);
+	TEST_RUN(SequenceTransactionCounts);
+
+	return TestFailures != 0;
+}
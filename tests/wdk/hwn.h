@@ -0,0 +1,50 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	hwn.h
+
+Abstract:
+
+	Host stand-in for the HwN settings layout.
+
+--*/
+
+#pragma once
+
+typedef enum _HWN_STATE
+{
+	HWN_OFF = 0,
+	HWN_ON = 1,
+	HWN_BLINK = 2
+} HWN_STATE;
+
+typedef enum _HWN_TYPE
+{
+	HWN_LED = 0,
+	HWN_VIBRATOR = 1
+} HWN_TYPE;
+
+typedef enum _HWN_SETTING
+{
+	HWN_INTENSITY,
+	HWN_PERIOD,
+	HWN_DUTY_CYCLE,
+	HWN_CYCLE_COUNT,
+	HWN_CYCLE_GRANULARITY,
+	HWN_CURRENT_MTE_RESERVED,
+	HWN_TOTAL_SETTINGS
+} HWN_SETTING;
+
+typedef struct _HWN_SETTINGS
+{
+	ULONG HwNId;
+	HWN_TYPE HwNType;
+	HWN_STATE OffOnBlink;
+	ULONG HwNSettings[HWN_TOTAL_SETTINGS];
+} HWN_SETTINGS, * PHWN_SETTINGS;
+
+#define HWN_SETTINGS_SIZE sizeof(HWN_SETTINGS)
+
+#define HWN_CURRENT_MTE_NOT_SUPPORTED 0xFFFFFFFF
@@ -0,0 +1,35 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	hwnclx.h
+
+Abstract:
+
+	Host stand-in for the HwN class extension client interface.
+
+--*/
+
+#pragma once
+
+#include <hwn.h>
+
+typedef struct _CLIENT_DEVICE_INFORMATION
+{
+	ULONG Version;
+	ULONG Size;
+	ULONG TotalHwNs;
+} CLIENT_DEVICE_INFORMATION, * PCLIENT_DEVICE_INFORMATION;
+
+typedef NTSTATUS DRIVER_INITIALIZE(PDRIVER_OBJECT DriverObject, PUNICODE_STRING RegistryPath);
+typedef NTSTATUS EVT_WDF_DRIVER_DEVICE_ADD(WDFDRIVER Driver, PWDFDEVICE_INIT DeviceInit);
+typedef VOID EVT_WDF_DRIVER_UNLOAD(WDFDRIVER Driver);
+
+typedef NTSTATUS HWN_CLIENT_INITIALIZE_DEVICE(WDFDEVICE Device, PVOID Context, WDFCMRESLIST ResourcesRaw, WDFCMRESLIST ResourcesTranslated);
+typedef NTSTATUS HWN_CLIENT_UNINITIALIZE_DEVICE(WDFDEVICE Device, PVOID Context);
+typedef NTSTATUS HWN_CLIENT_QUERY_DEVICE_INFORMATION(PVOID Context, PCLIENT_DEVICE_INFORMATION Information);
+typedef NTSTATUS HWN_CLIENT_START_DEVICE(PVOID Context);
+typedef NTSTATUS HWN_CLIENT_STOP_DEVICE(PVOID Context);
+typedef NTSTATUS HWN_CLIENT_SET_STATE(PVOID Context, PVOID Buffer, ULONG BufferLength, PULONG BytesWritten);
+typedef NTSTATUS HWN_CLIENT_GET_STATE(PVOID Context, PVOID OutputBuffer, ULONG OutputBufferLength, PVOID InputBuffer, ULONG InputBufferLength, PULONG BytesRead);
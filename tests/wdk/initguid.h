@@ -0,0 +1,14 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	initguid.h
+
+Abstract:
+
+	Host stand-in, the unit tests define no GUIDs.
+
+--*/
+
+#pragma once
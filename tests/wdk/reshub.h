@@ -0,0 +1,15 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	reshub.h
+
+Abstract:
+
+	Host stand-in, the unit tests never open the SPB target by
+	resource hub path.
+
+--*/
+
+#pragma once
@@ -0,0 +1,55 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	wdf.h
+
+Abstract:
+
+	Host stand-in for the KMDF objects the driver core touches. Handles
+	are opaque pointers; the test harness hands out the device context
+	itself as the parent of every work item and timer.
+
+--*/
+
+#pragma once
+
+#include <wdm.h>
+
+typedef PVOID WDFOBJECT, WDFDRIVER, WDFDEVICE, WDFIOTARGET, WDFMEMORY, WDFWAITLOCK;
+typedef PVOID WDFINTERRUPT, WDFCMRESLIST, WDFWORKITEM, WDFTIMER, WDFKEY;
+typedef struct WDFDEVICE_INIT* PWDFDEVICE_INIT;
+
+typedef struct _WDF_OBJECT_ATTRIBUTES WDF_OBJECT_ATTRIBUTES, * PWDF_OBJECT_ATTRIBUTES;
+
+#define WDF_NO_OBJECT_ATTRIBUTES NULL
+
+#define WDF_REL_TIMEOUT_IN_MS(Time) (-(LONGLONG)(Time) * 10000)
+
+#define WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(Type, Name)	\
+	Type* Name(WDFOBJECT Handle);
+
+typedef VOID EVT_WDF_OBJECT_CONTEXT_CLEANUP(WDFOBJECT Object);
+typedef BOOLEAN EVT_WDF_INTERRUPT_ISR(WDFINTERRUPT Interrupt, ULONG MessageID);
+typedef VOID EVT_WDF_INTERRUPT_DPC(WDFINTERRUPT Interrupt, WDFOBJECT AssociatedObject);
+typedef VOID EVT_WDF_WORKITEM(WDFWORKITEM WorkItem);
+typedef VOID EVT_WDF_TIMER(WDFTIMER Timer);
+
+NTSTATUS WdfWaitLockAcquire(WDFWAITLOCK Lock, PLONGLONG Timeout);
+VOID WdfWaitLockRelease(WDFWAITLOCK Lock);
+
+VOID WdfWorkItemEnqueue(WDFWORKITEM WorkItem);
+WDFOBJECT WdfWorkItemGetParentObject(WDFWORKITEM WorkItem);
+
+BOOLEAN WdfTimerStart(WDFTIMER Timer, LONGLONG DueTime);
+BOOLEAN WdfTimerStop(WDFTIMER Timer, BOOLEAN Wait);
+WDFOBJECT WdfTimerGetParentObject(WDFTIMER Timer);
+
+#define PLUGPLAY_REGKEY_DEVICE 1
+
+NTSTATUS WdfDeviceOpenRegistryKey(WDFDEVICE Device, ULONG DeviceInstanceKeyType, ACCESS_MASK DesiredAccess, PWDF_OBJECT_ATTRIBUTES KeyAttributes, WDFKEY* Key);
+NTSTATUS WdfRegistryQueryValue(WDFKEY Key, PUNICODE_STRING ValueName, ULONG ValueLength, PVOID Value, PULONG ValueLengthQueried, PULONG ValueType);
+NTSTATUS WdfRegistryQueryULong(WDFKEY Key, PUNICODE_STRING ValueName, PULONG Value);
+NTSTATUS WdfRegistryAssignULong(WDFKEY Key, PUNICODE_STRING ValueName, ULONG Value);
+VOID WdfRegistryClose(WDFKEY Key);
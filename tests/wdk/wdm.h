@@ -0,0 +1,259 @@
+/*++
+	SPDX-License-Identifier: BSD-3-Clause
+
+Module Name:
+
+	wdm.h
+
+Abstract:
+
+	Host stand-in for the subset of the kernel headers the driver core
+	uses, so aw8624.c can be compiled into the unit tests.
+
+--*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef void VOID, * PVOID;
+typedef int INT;
+typedef char CHAR, * PCHAR;
+typedef uint8_t UCHAR, * PUCHAR, UINT8, * PUINT8, BOOLEAN, * PBOOLEAN;
+typedef uint16_t USHORT, * PUSHORT, UINT16, * PUINT16;
+typedef int32_t LONG, * PLONG, INT32, NTSTATUS;
+typedef uint32_t ULONG, * PULONG, UINT32, ACCESS_MASK;
+typedef int64_t LONGLONG, * PLONGLONG;
+typedef uint64_t ULONGLONG;
+typedef uintptr_t ULONG_PTR, SIZE_T;
+typedef uint16_t WCHAR, * PWCHAR;
+typedef PVOID HANDLE, * PHANDLE;
+typedef UCHAR KIRQL;
+
+typedef union _LARGE_INTEGER
+{
+	struct
+	{
+		ULONG LowPart;
+		LONG HighPart;
+	};
+	LONGLONG QuadPart;
+} LARGE_INTEGER, * PLARGE_INTEGER;
+
+typedef struct _UNICODE_STRING
+{
+	USHORT Length;
+	USHORT MaximumLength;
+	PWCHAR Buffer;
+} UNICODE_STRING, * PUNICODE_STRING;
+
+typedef struct _DRIVER_OBJECT DRIVER_OBJECT, * PDRIVER_OBJECT;
+typedef struct _GUID
+{
+	ULONG Data1;
+	USHORT Data2;
+	USHORT Data3;
+	UCHAR Data4[8];
+} GUID, * LPGUID;
+
+#define TRUE	1
+#define FALSE	0
+
+#define IN
+#define OUT
+#define _In_
+#define _Out_
+#define _Inout_
+#define __in
+#define __out
+#define _In_reads_bytes_(x)
+#define __in_bcount(x)
+
+#define EXTERN_C_START
+#define EXTERN_C_END
+
+#define C_ASSERT(e) _Static_assert(e, #e)
+#define UNREFERENCED_PARAMETER(x) (void)(x)
+#define PAGED_CODE()
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define NT_SUCCESS(Status)					((NTSTATUS)(Status) >= 0)
+#define STATUS_SUCCESS						((NTSTATUS)0x00000000)
+#define STATUS_TIMEOUT						((NTSTATUS)0x00000102)
+#define STATUS_UNSUCCESSFUL					((NTSTATUS)0xC0000001)
+#define STATUS_NOT_IMPLEMENTED				((NTSTATUS)0xC0000002)
+#define STATUS_INVALID_PARAMETER			((NTSTATUS)0xC000000D)
+#define STATUS_OBJECT_NAME_NOT_FOUND		((NTSTATUS)0xC0000034)
+#define STATUS_CRC_ERROR					((NTSTATUS)0xC000003F)
+#define STATUS_INSUFFICIENT_RESOURCES		((NTSTATUS)0xC000009A)
+#define STATUS_DEVICE_DATA_ERROR			((NTSTATUS)0xC000009C)
+#define STATUS_FILE_CORRUPT_ERROR			((NTSTATUS)0xC0000102)
+#define STATUS_IO_TIMEOUT					((NTSTATUS)0xC00000B5)
+#define STATUS_INVALID_BUFFER_SIZE			((NTSTATUS)0xC0000206)
+
+#define RtlCopyMemory(Destination, Source, Length) memcpy(Destination, Source, Length)
+#define RtlZeroMemory(Destination, Length) memset(Destination, 0, Length)
+#define RtlFillMemory(Destination, Length, Fill) memset(Destination, Fill, Length)
+
+static inline SIZE_T
+RtlCompareMemory(
+	const VOID* Source1,
+	const VOID* Source2,
+	SIZE_T Length
+)
+{
+	SIZE_T i = 0;
+
+	while (i < Length && ((const UCHAR*)Source1)[i] == ((const UCHAR*)Source2)[i])
+	{
+		i++;
+	}
+
+	return i;
+}
+
+static inline int
+memcpy_s(
+	VOID* Destination,
+	SIZE_T DestinationSize,
+	const VOID* Source,
+	SIZE_T Count
+)
+{
+	if (Count > DestinationSize)
+	{
+		memset(Destination, 0, DestinationSize);
+		return 34;
+	}
+
+	memcpy(Destination, Source, Count);
+
+	return 0;
+}
+
+#define RTL_CONSTANT_STRING(s) { sizeof(s) - sizeof((s)[0]), sizeof(s), (PWCHAR)(s) }
+#define DECLARE_CONST_UNICODE_STRING(Name, String) const UNICODE_STRING Name = RTL_CONSTANT_STRING(String)
+
+//
+// Pool
+//
+#define POOL_FLAG_NON_PAGED	0x40
+#define POOL_FLAG_PAGED		0x100
+
+PVOID ExAllocatePool2(ULONGLONG Flags, SIZE_T NumberOfBytes, ULONG Tag);
+VOID ExFreePoolWithTag(PVOID P, ULONG Tag);
+
+//
+// Dispatcher objects and timing
+//
+typedef enum _EVENT_TYPE
+{
+	NotificationEvent,
+	SynchronizationEvent
+} EVENT_TYPE;
+
+typedef struct _KEVENT
+{
+	LONG Signaled;
+} KEVENT, * PKEVENT;
+
+typedef enum _KWAIT_REASON
+{
+	Executive
+} KWAIT_REASON;
+
+typedef enum _MODE
+{
+	KernelMode
+} KPROCESSOR_MODE;
+
+#define IO_NO_INCREMENT 0
+
+VOID KeInitializeEvent(PKEVENT Event, EVENT_TYPE Type, BOOLEAN State);
+LONG KeSetEvent(PKEVENT Event, LONG Increment, BOOLEAN Wait);
+VOID KeClearEvent(PKEVENT Event);
+NTSTATUS KeWaitForSingleObject(PVOID Object, KWAIT_REASON WaitReason, KPROCESSOR_MODE WaitMode, BOOLEAN Alertable, PLARGE_INTEGER Timeout);
+NTSTATUS KeDelayExecutionThread(KPROCESSOR_MODE WaitMode, BOOLEAN Alertable, PLARGE_INTEGER Interval);
+
+LONG InterlockedIncrement(volatile LONG* Addend);
+LONG InterlockedExchange(volatile LONG* Target, LONG Value);
+
+//
+// Files, for the waveform bank
+//
+typedef struct _OBJECT_ATTRIBUTES
+{
+	ULONG Length;
+	HANDLE RootDirectory;
+	PUNICODE_STRING ObjectName;
+	ULONG Attributes;
+	PVOID SecurityDescriptor;
+	PVOID SecurityQualityOfService;
+} OBJECT_ATTRIBUTES, * POBJECT_ATTRIBUTES;
+
+#define InitializeObjectAttributes(p, n, a, r, s)	\
+	do												\
+	{												\
+		(p)->Length = sizeof(OBJECT_ATTRIBUTES);	\
+		(p)->RootDirectory = (r);					\
+		(p)->ObjectName = (n);						\
+		(p)->Attributes = (a);						\
+		(p)->SecurityDescriptor = (s);				\
+		(p)->SecurityQualityOfService = NULL;		\
+	} while (0)
+
+#define OBJ_CASE_INSENSITIVE			0x00000040
+#define OBJ_KERNEL_HANDLE				0x00000200
+
+typedef struct _IO_STATUS_BLOCK
+{
+	NTSTATUS Status;
+	ULONG_PTR Information;
+} IO_STATUS_BLOCK, * PIO_STATUS_BLOCK;
+
+typedef struct _FILE_STANDARD_INFORMATION
+{
+	LARGE_INTEGER AllocationSize;
+	LARGE_INTEGER EndOfFile;
+	ULONG NumberOfLinks;
+	BOOLEAN DeletePending;
+	BOOLEAN Directory;
+} FILE_STANDARD_INFORMATION;
+
+typedef enum _FILE_INFORMATION_CLASS
+{
+	FileStandardInformation = 5
+} FILE_INFORMATION_CLASS;
+
+#define GENERIC_READ					0x80000000
+#define SYNCHRONIZE						0x00100000
+#define FILE_ATTRIBUTE_NORMAL			0x00000080
+#define FILE_SHARE_READ					0x00000001
+#define FILE_OPEN						0x00000001
+#define FILE_SYNCHRONOUS_IO_NONALERT	0x00000020
+#define FILE_NON_DIRECTORY_FILE			0x00000040
+
+NTSTATUS ZwCreateFile(PHANDLE FileHandle, ACCESS_MASK DesiredAccess, POBJECT_ATTRIBUTES ObjectAttributes, PIO_STATUS_BLOCK IoStatusBlock, PLARGE_INTEGER AllocationSize, ULONG FileAttributes, ULONG ShareAccess, ULONG CreateDisposition, ULONG CreateOptions, PVOID EaBuffer, ULONG EaLength);
+NTSTATUS ZwReadFile(HANDLE FileHandle, HANDLE Event, PVOID ApcRoutine, PVOID ApcContext, PIO_STATUS_BLOCK IoStatusBlock, PVOID Buffer, ULONG Length, PLARGE_INTEGER ByteOffset, PULONG Key);
+NTSTATUS ZwQueryInformationFile(HANDLE FileHandle, PIO_STATUS_BLOCK IoStatusBlock, PVOID FileInformation, ULONG Length, FILE_INFORMATION_CLASS FileInformationClass);
+NTSTATUS ZwClose(HANDLE Handle);
+
+//
+// Registry
+//
+#define KEY_QUERY_VALUE	0x0001
+#define KEY_SET_VALUE	0x0002
+#define KEY_READ		0x20019
+#define KEY_WRITE		0x20006
+#define REG_BINARY		3
+#define REG_DWORD		4
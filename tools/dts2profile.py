@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+#
+# Converts the aw8624 node of a Linux DTS into the binary profile the driver
+# reads from REG_BINARY "Profile" in the device's hardware key.
+#
+# Usage: dts2profile.py <fragment.dts> [profile.bin]
+#
+# Without an output file an INF AddReg line is printed instead.
+#
+
+import re
+import struct
+import sys
+
+SIGNATURE = 0x46505741  # "AWPF"
+VERSION = 1
+
+# Layout of AW8624_PROFILE in Device.h, little endian, 32 bytes
+LAYOUT = "<IIIIHHBBBBB4s3x"
+
+PROPERTIES = [
+	("vib_f0_pre", 1),
+	("vib_f0_coeff", 1),
+	("vib_cont_td", 1),
+	("vib_cont_zc_thr", 1),
+	("vib_cont_drv_lev", 1),
+	("vib_cont_drv_lvl_ov", 1),
+	("vib_cont_num_brk", 1),
+	("vib_tset", 1),
+	("vib_sw_brake", 1),
+	("vib_bemf_config", 4),
+]
+
+
+def parse(text):
+	values = {}
+	for name, count in PROPERTIES:
+		match = re.search(r"\b" + name + r"\s*=\s*<([^>]*)>", text)
+		if match is None:
+			sys.exit("missing property " + name)
+		cells = [int(cell, 0) for cell in match.group(1).split()]
+		if len(cells) != count:
+			sys.exit("%s has %d cells, expected %d" % (name, len(cells), count))
+		values[name] = cells
+	return values
+
+
+def pack(values):
+	if not 1000 <= values["vib_f0_pre"][0] <= 3000:
+		sys.exit("vib_f0_pre is outside 100-300 Hz")
+	# Same check as AW8624F0CoeffValid, every f0 in range needs a 16-bit period
+	coeff = values["vib_f0_coeff"][0]
+	if coeff == 0 or not (1000000000 // (3000 * coeff) >= 1 and
+			1000000000 // (1000 * coeff) <= 0xFFFF):
+		sys.exit("vib_f0_coeff does not map 100-300 Hz onto a 16-bit period")
+	# Same limit as AW8624_CONT_NUM_BRK_MAX, the count is a nibble of BEMF_NUM
+	if values["vib_cont_num_brk"][0] > 0xF:
+		sys.exit("vib_cont_num_brk does not fit BEMF_NUM")
+
+	return struct.pack(
+		LAYOUT,
+		SIGNATURE,
+		VERSION,
+		values["vib_f0_pre"][0],
+		values["vib_f0_coeff"][0],
+		values["vib_cont_td"][0],
+		values["vib_cont_zc_thr"][0],
+		values["vib_cont_drv_lev"][0],
+		values["vib_cont_drv_lvl_ov"][0],
+		values["vib_cont_num_brk"][0],
+		values["vib_tset"][0],
+		values["vib_sw_brake"][0],
+		bytes(values["vib_bemf_config"]))
+
+
+def main():
+	if len(sys.argv) not in (2, 3):
+		sys.exit("usage: dts2profile.py <fragment.dts> [profile.bin]")
+
+	with open(sys.argv[1]) as source:
+		blob = pack(parse(source.read()))
+
+	if len(sys.argv) == 3:
+		with open(sys.argv[2], "wb") as output:
+			output.write(blob)
+	else:
+		print("HKR,,Profile,0x00000001," + ",".join("%02x" % b for b in blob))
+
+
+if __name__ == "__main__":
+	main()